@@ -0,0 +1,476 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Batch GCD, (Bernstein's product and remainder trees, as used in Heninger et al., "Mining Your Ps
+// and Qs,") for a whole corpus of moduli at once: multiply the moduli up a binary tree, to their
+// product "P" at the root, then reduce P back down the tree, modulo the square of each node, so that
+// each leaf holds P mod N^2. Then (P mod N^2) / N is the product of all the other moduli, modulo N,
+// and its gcd with N is every factor that N shares with any of them. That's a few products and
+// divisions at each size, (quasi-linear, with GMP's subquadratic arithmetic,) instead of a gcd for
+// every pair of moduli. (Boost's division is quadratic, though, so there the top of the tree costs
+// the most, and a corpus of more than a few thousand moduli wants the GMP build.)
+//
+// The nodes of a level are independent, so each level is split into chunks, and each chunk across
+// all workers, at the narrowest of our width-templated integers that holds it, (or unbounded ones,
+// near the root). Any level that would overflow the memory budget goes to disk as it's built, and
+// is streamed back, chunk by chunk, on the way down.
+//
+// A modulus whose gcd is itself shares all of its factors, (or is a duplicate,) so it's resolved by
+// pairwise gcds against the (few) other moduli that share anything.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "qimcifa.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace Qimcifa {
+
+// Memory for tree levels, in MiB, by default, before the rest go to disk
+constexpr size_t DEFAULT_GCD_MEMORY = 4096U;
+// Nodes per chunk, (the unit of streaming from disk, and of dispatch by width,) which must be even
+constexpr size_t GCD_CHUNK_NODES = 1U << 12U;
+
+// Tree nodes far outgrow any fixed width, so levels are stored at unbounded width, (where we have it).
+#if USE_GMP
+typedef boost::multiprecision::mpz_int CorpusInteger;
+#elif USE_BOOST
+typedef boost::multiprecision::cpp_int CorpusInteger;
+#else
+typedef BigInteger CorpusInteger;
+#endif
+
+// As a word count, then the words, least significant first
+inline void writeCorpusInteger(std::ostream& out, const CorpusInteger& n)
+{
+    std::vector<uint64_t> words;
+#if USE_GMP
+    size_t count = 0U;
+    words.resize((mpz_sizeinbase(n.backend().data(), 2) + 63U) >> 6U);
+    mpz_export(words.data(), &count, -1, sizeof(uint64_t), 0, 0, n.backend().data());
+    words.resize(count);
+#elif USE_BOOST
+    boost::multiprecision::export_bits(n, std::back_inserter(words), 64U, false);
+#else
+    size_t count = BIG_INTEGER_WORD_SIZE;
+    while (count && !n.bits[count - 1U]) {
+        --count;
+    }
+    words.assign(n.bits, n.bits + count);
+#endif
+    const uint64_t size = words.size();
+    out.write((const char*)&size, sizeof(size));
+    out.write((const char*)words.data(), size * sizeof(uint64_t));
+}
+
+inline bool readCorpusInteger(std::istream& in, CorpusInteger& n)
+{
+    uint64_t size = 0U;
+    if (!in.read((char*)&size, sizeof(size))) {
+        return false;
+    }
+    std::vector<uint64_t> words(size);
+    if (size && !in.read((char*)words.data(), size * sizeof(uint64_t))) {
+        return false;
+    }
+#if USE_GMP
+    mpz_import(n.backend().data(), size, -1, sizeof(uint64_t), 0, 0, words.data());
+#elif USE_BOOST
+    n = 0U;
+    if (size) {
+        boost::multiprecision::import_bits(n, words.begin(), words.end(), 64U, false);
+    }
+#else
+    if (size > (uint64_t)BIG_INTEGER_WORD_SIZE) {
+        return false;
+    }
+    n = 0U;
+    for (size_t i = 0U; i < size; ++i) {
+        n.bits[i] = words[i];
+    }
+#endif
+
+    return true;
+}
+
+// One level of a tree, in order, held in memory, or (once it outgrows its share of the budget) in a file
+struct GcdTreeLevel {
+    std::vector<CorpusInteger> values;
+    // (Empty while in memory)
+    std::string path;
+    std::ofstream out;
+    size_t count;
+    uint64_t maxBits;
+    // (Approximate, for the memory budget)
+    size_t bytes;
+    // Memory left, shared by all levels
+    size_t& memoryLeft;
+
+    GcdTreeLevel(size_t& memory)
+        : count(0U)
+        , maxBits(0U)
+        , bytes(0U)
+        , memoryLeft(memory)
+    {
+        // Intentionally left blank.
+    }
+
+    ~GcdTreeLevel() { release(); }
+
+    bool isOnDisk() const { return !path.empty(); }
+
+    // Append a value, and write everything to "spillPath," if it no longer fits in memory.
+    void add(CorpusInteger&& n, const std::string& spillPath)
+    {
+        const uint64_t bits = log2(n) + 1U;
+        const size_t size = (size_t)((bits + 7U) >> 3U) + sizeof(CorpusInteger);
+        maxBits = std::max(maxBits, bits);
+        ++count;
+        if (!isOnDisk() && (size > memoryLeft)) {
+            path = spillPath;
+            out.open(path, std::ios::binary | std::ios::trunc);
+            for (const CorpusInteger& v : values) {
+                writeCorpusInteger(out, v);
+            }
+            memoryLeft += bytes;
+            bytes = 0U;
+            values = std::vector<CorpusInteger>();
+        }
+        if (isOnDisk()) {
+            writeCorpusInteger(out, n);
+            return;
+        }
+        memoryLeft -= size;
+        bytes += size;
+        values.push_back(std::move(n));
+    }
+
+    // (Call when the level is complete.)
+    bool close()
+    {
+        if (!isOnDisk()) {
+            return true;
+        }
+        out.close();
+
+        return !out.fail();
+    }
+
+    void release()
+    {
+        memoryLeft += bytes;
+        bytes = 0U;
+        values = std::vector<CorpusInteger>();
+        if (isOnDisk()) {
+            if (out.is_open()) {
+                out.close();
+            }
+            std::remove(path.c_str());
+            path.clear();
+        }
+    }
+};
+
+// Reads a level back in order, "size" values at a time
+struct GcdLevelReader {
+    const GcdTreeLevel& level;
+    std::ifstream in;
+    size_t next;
+
+    GcdLevelReader(const GcdTreeLevel& l)
+        : level(l)
+        , next(0U)
+    {
+        if (level.isOnDisk()) {
+            in.open(level.path, std::ios::binary);
+        }
+    }
+
+    // False on a read error, (or a missing file)
+    bool read(const size_t& size, std::vector<CorpusInteger>& chunk)
+    {
+        chunk.clear();
+        const size_t end = std::min(level.count, next + size);
+        if (!level.isOnDisk()) {
+            chunk.assign(level.values.begin() + next, level.values.begin() + end);
+            next = end;
+            return true;
+        }
+        chunk.resize(end - next);
+        for (CorpusInteger& n : chunk) {
+            if (!readCorpusInteger(in, n)) {
+                return false;
+            }
+        }
+        next = end;
+
+        return true;
+    }
+};
+
+// One chunk of one tree level, for whichever integer type "run()" is given
+struct GcdChunk {
+    enum Step {
+        // Products of adjacent pairs of "nodes," (or a copy, for an odd one out at the end)
+        PRODUCT,
+        // The parent's remainder, modulo the square of each of "nodes"
+        REMAINDER,
+        // gcd((parent's remainder mod N^2) / N, N) for each modulus N in "nodes"
+        LEAF
+    };
+    Step step;
+    std::vector<CorpusInteger> nodes;
+    // Remainders of the parents of "nodes," (not for products)
+    std::vector<CorpusInteger> parents;
+    std::vector<CorpusInteger> results;
+    // Bits that any integer type must hold, for this chunk
+    uint32_t width;
+    unsigned workerCount;
+
+    template <typename BigInteger> CorpusInteger compute(const size_t& i) const
+    {
+        if (step == PRODUCT) {
+            const size_t j = i << 1U;
+            if ((j + 1U) == nodes.size()) {
+                return nodes[j];
+            }
+            return (CorpusInteger)(BigInteger)((BigInteger)nodes[j] * (BigInteger)nodes[j + 1U]);
+        }
+        const BigInteger n = (BigInteger)nodes[i];
+        const BigInteger r = (BigInteger)parents[i >> 1U] % (BigInteger)(n * n);
+        if (step == REMAINDER) {
+            return (CorpusInteger)r;
+        }
+
+        return (CorpusInteger)gcd((BigInteger)(r / n), n);
+    }
+
+    template <typename BigInteger> void run()
+    {
+        const size_t size = (step == PRODUCT) ? ((nodes.size() + 1U) >> 1U) : nodes.size();
+        results.resize(size);
+        const size_t stride = (size + workerCount - 1U) / std::max(1U, workerCount);
+        std::vector<std::future<void>> futures;
+        for (size_t begin = 0U; begin < size; begin += stride) {
+            const size_t end = std::min(size, begin + stride);
+            futures.push_back(std::async(std::launch::async, [this, begin, end]() {
+                for (size_t i = begin; i < end; ++i) {
+                    results[i] = compute<BigInteger>(i);
+                }
+            }));
+        }
+        for (std::future<void>& future : futures) {
+            future.get();
+        }
+    }
+};
+
+// A modulus that shares a factor with another
+struct SharedModulus {
+    size_t line;
+    CorpusInteger modulus;
+    CorpusInteger factor;
+};
+
+// Run "chunk" on the narrowest integer type that holds "chunk.width" bits, returning false if there's none.
+typedef std::function<bool(GcdChunk&)> GcdDispatch;
+
+// Read moduli, one per line, (skipping blank lines and '#' comments,) and report every one that shares
+// a factor with another. Levels past "memoryMiB" go to files under "spillDir."
+inline int runBatchGcd(const std::string& corpusFile, const size_t& memoryMiB, const std::string& spillDir,
+    const unsigned& workerCount, const GcdDispatch& dispatch)
+{
+    std::ifstream corpus(corpusFile);
+    if (!corpus.is_open()) {
+        std::cout << "Could not open corpus file: " << corpusFile << std::endl;
+        return 1;
+    }
+    const auto start = std::chrono::high_resolution_clock::now();
+    const auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+    const auto getSpillPath = [&spillDir](const std::string& kind, const size_t& level) {
+        return spillDir + "/qimcifa_gcd_" + kind + "_" + std::to_string(level) + ".bin";
+    };
+    const auto runChunk = [&dispatch](GcdChunk& chunk) {
+        if (dispatch(chunk)) {
+            return true;
+        }
+#if USE_GMP || USE_BOOST
+        chunk.run<CorpusInteger>();
+        return true;
+#else
+        std::cout << "Batch GCD needs " << chunk.width << "-bit integers, but this build's are " << BIG_INTEGER_BITS
+                  << " bits. (Build with Boost or GMP, for unbounded integers.)" << std::endl;
+        return false;
+#endif
+    };
+
+    size_t memoryLeft = memoryMiB << 20U;
+    // Product tree levels, from the moduli up to their product, (with unique pointers, since levels own streams)
+    std::vector<std::unique_ptr<GcdTreeLevel>> products;
+    products.emplace_back(new GcdTreeLevel(memoryLeft));
+    std::vector<size_t> lines;
+    std::string line;
+    for (size_t lineNumber = 1U; std::getline(corpus, line); ++lineNumber) {
+        if (line.empty() || (line.find_first_not_of(" \t\r") == std::string::npos) || (line[0] == '#')) {
+            continue;
+        }
+        std::stringstream ss(line);
+        CorpusInteger n;
+        ss >> n;
+        if (ss.fail() || (n < 2U)) {
+            std::cout << "Line " << lineNumber << ": invalid modulus: " << line << std::endl;
+            continue;
+        }
+        products[0U]->add(std::move(n), getSpillPath("product", 0U));
+        lines.push_back(lineNumber);
+    }
+    if (!products[0U]->count) {
+        std::cout << "No moduli in corpus file: " << corpusFile << std::endl;
+        return 1;
+    }
+
+    const auto report = [&elapsed](const std::string& kind, const size_t& level, const GcdTreeLevel& l) {
+        std::cout << "Batch GCD: " << kind << " level " << level << ": " << l.count << " nodes, up to " << l.maxBits
+                  << " bits" << (l.isOnDisk() ? ", on disk" : "") << " (after " << elapsed() << " seconds)"
+                  << std::endl;
+    };
+    const auto stop = [&elapsed]() {
+        std::cout << "Interrupted (after " << elapsed() << " seconds)" << std::endl;
+        return 1;
+    };
+    const auto fail = [](const GcdTreeLevel& l) {
+        std::cout << "Could not " << (l.isOnDisk() ? ("read or write " + l.path) : "build a tree level") << "!"
+                  << std::endl;
+        return 1;
+    };
+
+    report("product", 0U, *products[0U]);
+    if (!products[0U]->close()) {
+        return fail(*products[0U]);
+    }
+    GcdChunk chunk;
+    chunk.workerCount = workerCount;
+    while (products.back()->count > 1U) {
+        const GcdTreeLevel& children = *products.back();
+        std::unique_ptr<GcdTreeLevel> parents(new GcdTreeLevel(memoryLeft));
+        GcdLevelReader reader(children);
+        chunk.step = GcdChunk::PRODUCT;
+        chunk.width = (uint32_t)(children.maxBits << 1U);
+        for (size_t i = 0U; i < children.count; i += GCD_CHUNK_NODES) {
+            if (getStopRequest().load(std::memory_order_relaxed)) {
+                return stop();
+            }
+            if (!reader.read(GCD_CHUNK_NODES, chunk.nodes)) {
+                return fail(children);
+            }
+            if (!runChunk(chunk)) {
+                return 1;
+            }
+            for (CorpusInteger& n : chunk.results) {
+                parents->add(std::move(n), getSpillPath("product", products.size()));
+            }
+        }
+        if (!parents->close()) {
+            return fail(*parents);
+        }
+        report("product", products.size(), *parents);
+        products.push_back(std::move(parents));
+    }
+
+    // Down the tree, each level's remainders from its parents', (and the root's is the root itself)
+    std::vector<SharedModulus> shared;
+    std::unique_ptr<GcdTreeLevel> remainders = std::move(products.back());
+    products.pop_back();
+    for (size_t level = products.size(); level > 0U; --level) {
+        const GcdTreeLevel& nodes = *products[level - 1U];
+        const bool isLeaf = (level == 1U);
+        std::unique_ptr<GcdTreeLevel> next(new GcdTreeLevel(memoryLeft));
+        GcdLevelReader nodeReader(nodes);
+        GcdLevelReader parentReader(*remainders);
+        chunk.step = isLeaf ? GcdChunk::LEAF : GcdChunk::REMAINDER;
+        chunk.width = (uint32_t)(std::max(remainders->maxBits, nodes.maxBits << 1U) + 1U);
+        for (size_t i = 0U; i < nodes.count; i += GCD_CHUNK_NODES) {
+            if (getStopRequest().load(std::memory_order_relaxed)) {
+                return stop();
+            }
+            if (!nodeReader.read(GCD_CHUNK_NODES, chunk.nodes)) {
+                return fail(nodes);
+            }
+            if (!parentReader.read(GCD_CHUNK_NODES >> 1U, chunk.parents)) {
+                return fail(*remainders);
+            }
+            if (!runChunk(chunk)) {
+                return 1;
+            }
+            for (size_t j = 0U; j < chunk.results.size(); ++j) {
+                if (!isLeaf) {
+                    next->add(std::move(chunk.results[j]), getSpillPath("remainder", level - 1U));
+                } else if (chunk.results[j] != 1U) {
+                    shared.push_back(SharedModulus{ lines[i + j], chunk.nodes[j], chunk.results[j] });
+                }
+            }
+        }
+        if (!isLeaf) {
+            if (!next->close()) {
+                return fail(*next);
+            }
+            report("remainder", level - 1U, *next);
+        }
+        remainders = std::move(next);
+        products.pop_back();
+    }
+
+    // A modulus that shares all its factors needs a partner, to split.
+    for (SharedModulus& s : shared) {
+        if (s.factor != s.modulus) {
+            std::cout << "Line " << s.line << ": Found " << s.factor << " * " << (CorpusInteger)(s.modulus / s.factor)
+                      << " = " << s.modulus << std::endl;
+            continue;
+        }
+        const SharedModulus* divides = nullptr;
+        bool isSplit = false;
+        for (const SharedModulus& t : shared) {
+            if (&t == &s) {
+                continue;
+            }
+            const CorpusInteger g = gcd(s.modulus, t.modulus);
+            if ((g != 1U) && (g != s.modulus)) {
+                std::cout << "Line " << s.line << ": Found " << g << " * " << (CorpusInteger)(s.modulus / g) << " = "
+                          << s.modulus << " (with line " << t.line << ")" << std::endl;
+                isSplit = true;
+                break;
+            }
+            if ((g == s.modulus) && !divides) {
+                divides = &t;
+            }
+        }
+        if (isSplit) {
+            continue;
+        }
+        if (divides) {
+            std::cout << "Line " << s.line << ": " << s.modulus
+                      << ((divides->modulus == s.modulus) ? " is a duplicate of line " : " divides line ")
+                      << divides->line << std::endl;
+        } else {
+            std::cout << "Line " << s.line << ": " << s.modulus
+                      << " shares all its factors, (but no single modulus splits it)" << std::endl;
+        }
+    }
+    std::cout << "Batch GCD: " << shared.size() << " of " << lines.size() << " moduli share a factor (in "
+              << elapsed() << " seconds)" << std::endl;
+
+    return 0;
+}
+} // namespace Qimcifa
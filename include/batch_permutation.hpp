@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Keyed pseudo-random permutation of batch indices, for the "quantum-inspired" random mode.
+//
+// Guessing uniformly at random, with replacement, would repeat batches. Instead, we push each
+// (sequential) claim index through a bijection of "[0, batchCount)": a balanced Feistel network
+// over the smallest even bit width that covers the range, with "cycle walking" to stay inside it.
+// The round function is a counter-based generator, (the SplitMix64 finalizer of the round key and
+// half-block,) so any index maps independently, in a few dozen instructions, with no state but the
+// key. Every batch is still visited exactly once, but each one is equally likely to come next, so
+// the expected time to solution is the same from any point, and an interruption loses nothing in
+// expectation. Nodes that share the key need no further coordination than their claim slices.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Qimcifa {
+
+constexpr int FEISTEL_ROUNDS = 6;
+
+// SplitMix64 output function, (a strong 64-bit mixer,) as a counter-based generator
+inline uint64_t mix64(uint64_t x)
+{
+    x = (x ^ (x >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27U)) * 0x94D049BB133111EBULL;
+
+    return x ^ (x >> 31U);
+}
+
+// FNV-1a, to key the order from a (decimal) number and seed, identically on every node
+inline uint64_t hashKey(const std::string& s, const uint64_t& seed)
+{
+    uint64_t h = 0xCBF29CE484222325ULL ^ mix64(seed);
+    for (const char& c : s) {
+        h = (h ^ (unsigned char)c) * 0x100000001B3ULL;
+    }
+
+    return mix64(h);
+}
+
+struct BatchPermutation {
+    uint64_t size;
+    unsigned halfBits;
+    uint64_t halfMask;
+    uint64_t roundKeys[FEISTEL_ROUNDS];
+
+    BatchPermutation() { setDomain(1U, 0U); }
+
+    void setDomain(const uint64_t& s, const uint64_t& key)
+    {
+        size = s ? s : 1U;
+        unsigned bits = 1U;
+        while ((bits < 64U) && ((size - 1U) >> bits)) {
+            ++bits;
+        }
+        halfBits = (bits + 1U) >> 1U;
+        halfMask = (halfBits < 64U) ? ((1ULL << halfBits) - 1U) : ~0ULL;
+        for (int r = 0; r < FEISTEL_ROUNDS; ++r) {
+            roundKeys[r] = mix64(key + (r + 1) * 0x9E3779B97F4A7C15ULL);
+        }
+    }
+
+    // One pass of the Feistel network, over [0, 2^(2 * halfBits))
+    inline uint64_t permute(const uint64_t& x) const
+    {
+        uint64_t left = x >> halfBits;
+        uint64_t right = x & halfMask;
+        for (int r = 0; r < FEISTEL_ROUNDS; ++r) {
+            const uint64_t next = left ^ (mix64(right ^ roundKeys[r]) & halfMask);
+            left = right;
+            right = next;
+        }
+
+        return (left << halfBits) | right;
+    }
+
+    // Map "i," (which must be less than "size,") to its batch index. The network's domain is less
+    // than 4 times "size," so this walks fewer than 4 steps, on average.
+    inline uint64_t map(uint64_t i) const
+    {
+        do {
+            i = permute(i);
+        } while (i >= size);
+
+        return i;
+    }
+};
+} // namespace Qimcifa
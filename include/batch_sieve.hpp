@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Prime-only candidate filtering, for the semiprime search: a segmented sieve over each batch.
+//
+// When the factor we look for is prime, a wheel survivor with a small prime factor (above the wheel
+// primes) can never be it. So, before any multiprecision division, each worker sieves its batch's
+// window of backward indices with the primes up to a (tunable) bound, exactly as the segmented
+// Sieve of Eratosthenes in prime_generator does, segment by segment. In backward index space, the
+// multiples of an odd prime "p" (above 3) fall in two residue classes modulo "2p," (one of even and
+// one of odd indices,) so each sieving prime only needs its offset into the window, (one small
+// remainder of the batch start,) and then marks with a constant stride. The window is a bit set of
+// 64 KB, which stays in cache, and only its unmarked candidates are divided.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "wheel_factorization.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Qimcifa {
+
+// Sieve each batch with the primes up to this bound, by default, (or 0 for none).
+constexpr size_t DEFAULT_SIEVE_BOUND = 1U << 16U;
+
+struct SievePrime {
+    uint32_t prime;
+    // Backward index stride between multiples of the same parity, "2p"
+    uint32_t stride;
+    // Residue classes, modulo "2p," of the even and odd backward indices whose forward values "p" divides
+    uint32_t evenClass;
+    uint32_t oddClass;
+};
+
+// Every prime up to "bound," (by the plain Sieve of Eratosthenes). This is only ever called once per
+// run, for a bound of about 2^16, so it doesn't share prime_generator's sieve: that one is built into its
+// own executable, on its DispatchQueue, with its own BIG_INT_BITS integer type, (and a header that can't
+// be included alongside this one, as it defines non-inline functions).
+inline std::vector<uint32_t> getPrimesTo(const size_t& bound)
+{
+    std::vector<uint32_t> primes;
+    std::vector<bool> isComposite(bound + 1U, false);
+    for (size_t p = 2U; p <= bound; ++p) {
+        if (isComposite[p]) {
+            continue;
+        }
+        for (size_t m = p * p; m <= bound; m += p) {
+            isComposite[m] = true;
+        }
+        primes.push_back((uint32_t)p);
+    }
+
+    return primes;
+}
+
+// The sieving primes above the wheel primes of "level," up to "bound," built once per level and
+// bound, per process, and shared between all threads
+inline const std::vector<SievePrime>& getSievePrimes(const size_t& level, const size_t& bound)
+{
+    static std::mutex sieveMutex;
+    static std::map<std::pair<size_t, size_t>, std::unique_ptr<const std::vector<SievePrime>>> sieveTables;
+
+    std::lock_guard<std::mutex> lock(sieveMutex);
+    std::unique_ptr<const std::vector<SievePrime>>& table = sieveTables[std::make_pair(level, bound)];
+    if (table) {
+        return *table;
+    }
+
+    // (Backward indices already exclude multiples of 2 and 3.)
+    const size_t wheelLevel = (level < MAX_WHEEL_LEVEL) ? level : MAX_WHEEL_LEVEL;
+    const size_t largestWheelPrime = (wheelLevel > 2U) ? WHEEL_TABLE_PRIMES[wheelLevel - 1U] : 3U;
+
+    std::vector<SievePrime> primes;
+    for (const uint32_t& prime : getPrimesTo(bound)) {
+        if (prime <= largestWheelPrime) {
+            continue;
+        }
+
+        // forward(b) is 3b - 1 for even "b," and 3b - 2 for odd "b."
+        const uint32_t inverse3 = ((prime % 3U) == 1U) ? ((2U * prime + 1U) / 3U) : ((prime + 1U) / 3U);
+        const uint32_t even = (inverse3 & 1U) ? (inverse3 + prime) : inverse3;
+        const uint32_t odd2 = (2U * inverse3) % prime;
+        const uint32_t odd = (odd2 & 1U) ? odd2 : (odd2 + prime);
+        primes.push_back(SievePrime{ prime, 2U * prime, even, odd });
+    }
+    table.reset(new std::vector<SievePrime>(primes));
+
+    return *table;
+}
+
+// One worker's sieve window, (a bit per backward index of one batch)
+struct BatchSieve {
+    const std::vector<SievePrime>* primes;
+    size_t window;
+    std::vector<uint64_t> composites;
+
+    // (Without sieving primes, nothing is ever marked, and the sieve costs one comparison per candidate.)
+    BatchSieve(const std::vector<SievePrime>* p, const size_t& w)
+        : primes((p && !p->empty()) ? p : nullptr)
+        , window(primes ? w : 0U)
+        , composites((window + 63U) >> 6U)
+    {
+        // Intentionally left blank.
+    }
+
+    inline void set(const size_t& o) { composites[o >> 6U] |= 1ULL << (o & 63U); }
+
+    inline void markClass(const uint32_t& residueClass, const uint32_t& stride, const uint32_t& startResidue)
+    {
+        size_t o = (residueClass >= startResidue) ? (residueClass - startResidue)
+                                                  : (residueClass + stride - startResidue);
+        for (; o < window; o += stride) {
+            set(o);
+        }
+    }
+
+    // Mark the multiples of the sieving primes in the batch window that starts at backward index "start."
+    template <typename BigInteger> void mark(const BigInteger& start)
+    {
+        if (!primes) {
+            return;
+        }
+        std::fill(composites.begin(), composites.end(), 0U);
+        for (const SievePrime& sp : *primes) {
+            const uint32_t startResidue = (uint32_t)(start % sp.stride);
+            markClass(sp.evenClass, sp.stride, startResidue);
+            markClass(sp.oddClass, sp.stride, startResidue);
+        }
+
+        // A sieving prime is its own multiple, but it could still be the factor.
+        const size_t bound = primes->back().prime;
+        if (start > bound) {
+            return;
+        }
+        const size_t first = (size_t)start;
+        for (const SievePrime& sp : *primes) {
+            // (Inverse of forward(), for a prime above 3)
+            const size_t b = (sp.prime + 1U + ((sp.prime % 6U) == 1U)) / 3U;
+            if ((b >= first) && ((b - first) < window)) {
+                composites[(b - first) >> 6U] &= ~(1ULL << ((b - first) & 63U));
+            }
+        }
+    }
+
+    // Whether the candidate at offset "o" into the window has a sieving prime factor
+    inline bool isComposite(const size_t& o) const
+    {
+        return (o < window) && ((composites[o >> 6U] >> (o & 63U)) & 1U);
+    }
+};
+} // namespace Qimcifa
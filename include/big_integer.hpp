@@ -397,10 +397,12 @@ inline void bi_rshift_ip(BigInteger* left, BIG_INTEGER_WORD right)
 
 inline int bi_log2(const BigInteger& n)
 {
-    int pw = 0;
-    BigInteger p = n >> 1U;
-    while (bi_compare_0(p) != 0) {
-        bi_rshift_ip(&p, 1U);
+    int i = BIG_INTEGER_MAX_WORD_INDEX;
+    while ((i > 0) && !n.bits[i]) {
+        --i;
+    }
+    int pw = i << BIG_INTEGER_WORD_POWER;
+    for (BIG_INTEGER_WORD w = n.bits[i] >> 1U; w; w >>= 1U) {
         ++pw;
     }
     return pw;
@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// A store of tuner calibrations, keyed by everything that changes the time per batch: the bit
+// width of the number, the integer backend that the width selects, the build (and sieve) options
+// that change the search kernel, and the CPU model. The tuner adds (or replaces) one entry per level for each
+// number it times, so one file can serve a mixed fleet and inputs of many sizes. For a number of a
+// width that wasn't timed, the time per batch is interpolated (log-linearly) between the nearest
+// calibrated widths on either side, within the same backend. Entries for another backend, build, or
+// CPU never match, so a mismatched calibration falls back to the default level, visibly, instead of
+// quietly choosing a slower level.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Qimcifa {
+
+constexpr char CALIBRATION_STORE_FILE[] = "qimcifa_calibration.ssv";
+constexpr char CALIBRATION_STORE_HEADER[] = "qimcifa-calibration 2: bits backend options cpu level batch_seconds";
+
+// Build (and run) options that change the search kernel, (and so the time per batch)
+inline std::string getSearchOptions(const size_t& sieveBound)
+{
+    std::string options;
+#if IS_RSA_SEMIPRIME
+    options += "+semiprime";
+#endif
+#if IS_SQUARES_CONGRUENCE_CHECK
+    options += "+squares";
+#endif
+#if IS_QUOTIENT_TRACKING
+    options += "+tracking";
+#endif
+#if IS_RSA_SEMIPRIME && !IS_SQUARES_CONGRUENCE_CHECK
+    if (sieveBound) {
+        options += "+sieve" + std::to_string(sieveBound);
+    }
+#else
+    (void)sieveBound;
+#endif
+
+    return options.empty() ? std::string("plain") : options.substr(1U);
+}
+
+// CPU model name, with whitespace replaced, (so it's one field of the store)
+inline std::string getCpuModel()
+{
+    static const std::string model = [] {
+        std::string name;
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0U, 10U, "model name") && line.compare(0U, 9U, "Processor")) {
+                continue;
+            }
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                name = line.substr(colon + 1U);
+                break;
+            }
+        }
+        std::string field;
+        for (const char& c : name) {
+            if ((c == ' ') || (c == '\t')) {
+                if (!field.empty() && (field.back() != '_')) {
+                    field += '_';
+                }
+            } else {
+                field += c;
+            }
+        }
+        while (!field.empty() && (field.back() == '_')) {
+            field.pop_back();
+        }
+
+        return field.empty() ? std::string("unknown") : field;
+    }();
+
+    return model;
+}
+
+// The integer backend for a width, (as chosen by the width dispatch,) by name
+template <typename BigInteger> std::string getBackendName()
+{
+    if (std::is_same<BigInteger, uint64_t>::value) {
+        return "u64";
+    }
+    if (std::is_same<BigInteger, unsigned __int128>::value) {
+        return "u128";
+    }
+#if USE_GMP
+    return "gmp";
+#elif USE_BOOST
+    return "boost" + std::to_string(8U * sizeof(BigInteger));
+#else
+    return "pure" + std::to_string(8U * sizeof(BigInteger));
+#endif
+}
+
+struct CalibrationEntry {
+    uint32_t bits;
+    std::string backend;
+    std::string options;
+    std::string cpu;
+    int64_t level;
+    // (Seconds, for one batch, on one thread)
+    double batchSeconds;
+
+    bool isSameKey(const std::string& b, const std::string& o, const std::string& c) const
+    {
+        return (backend == b) && (options == o) && (cpu == c);
+    }
+};
+
+struct CalibrationStore {
+    const std::string path;
+    // This run's search options, (see getSearchOptions())
+    const std::string options;
+    std::vector<CalibrationEntry> entries;
+    // The file exists, but isn't a store, (e.g., from an older tuner)
+    bool isLegacy;
+
+    CalibrationStore(const std::string& o, const std::string& p = CALIBRATION_STORE_FILE)
+        : path(p)
+        , options(o)
+        , isLegacy(false)
+    {
+        // Intentionally left blank.
+    }
+
+    bool load()
+    {
+        entries.clear();
+        isLegacy = false;
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::string line;
+        if (!std::getline(file, line) || (line != CALIBRATION_STORE_HEADER)) {
+            isLegacy = true;
+            return false;
+        }
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            CalibrationEntry entry;
+            if ((ss >> entry.bits >> entry.backend >> entry.options >> entry.cpu >> entry.level >>
+                    entry.batchSeconds) &&
+                (entry.batchSeconds > 0.0)) {
+                entries.push_back(entry);
+            }
+        }
+
+        return true;
+    }
+
+    // Add an entry, replacing any for the same key, width, and level.
+    void update(const CalibrationEntry& entry)
+    {
+        for (CalibrationEntry& e : entries) {
+            if ((e.bits == entry.bits) && (e.level == entry.level) &&
+                e.isSameKey(entry.backend, entry.options, entry.cpu)) {
+                e = entry;
+                return;
+            }
+        }
+        entries.push_back(entry);
+    }
+
+    // Rewrite the store, atomically replacing the last one, (so a concurrent reader never sees half).
+    bool save()
+    {
+        std::sort(entries.begin(), entries.end(), [](const CalibrationEntry& a, const CalibrationEntry& b) {
+            if (a.cpu != b.cpu) {
+                return a.cpu < b.cpu;
+            }
+            if (a.options != b.options) {
+                return a.options < b.options;
+            }
+            if (a.bits != b.bits) {
+                return a.bits < b.bits;
+            }
+            return a.level < b.level;
+        });
+
+        std::stringstream ss;
+        ss << CALIBRATION_STORE_HEADER << std::endl;
+        for (const CalibrationEntry& e : entries) {
+            ss << e.bits << " " << e.backend << " " << e.options << " " << e.cpu << " " << e.level << " "
+               << e.batchSeconds << std::endl;
+        }
+        const std::string contents = ss.str();
+
+        const std::string tmpPath = path + ".tmp";
+        std::FILE* file = std::fopen(tmpPath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        const bool isWritten = std::fwrite(contents.data(), 1U, contents.size(), file) == contents.size();
+        if (std::fclose(file) || !isWritten || std::rename(tmpPath.c_str(), path.c_str())) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    // Time per batch at "level," for a number of "bits" width, interpolated between the nearest
+    // calibrated widths, (or clamped to the nearest one, outside them,) or negative, if uncalibrated
+    double getBatchSeconds(const uint32_t& bits, const std::string& backend, const int64_t& level) const
+    {
+        const std::string cpu = getCpuModel();
+        const CalibrationEntry* below = nullptr;
+        const CalibrationEntry* above = nullptr;
+        for (const CalibrationEntry& e : entries) {
+            if ((e.level != level) || !e.isSameKey(backend, options, cpu)) {
+                continue;
+            }
+            if ((e.bits <= bits) && (!below || (e.bits > below->bits))) {
+                below = &e;
+            }
+            if ((e.bits >= bits) && (!above || (e.bits < above->bits))) {
+                above = &e;
+            }
+        }
+
+        if (!below || !above) {
+            return below ? below->batchSeconds : (above ? above->batchSeconds : -1.0);
+        }
+        if (below->bits == above->bits) {
+            return below->batchSeconds;
+        }
+        const double t = (double)(bits - below->bits) / (double)(above->bits - below->bits);
+
+        const double logBelow = std::log(below->batchSeconds);
+
+        return std::exp(logBelow + t * (std::log(above->batchSeconds) - logBelow));
+    }
+
+    // Every level searches the same batches, so the best level has the least time per batch. Returns
+    // the level, (or -1, if nothing matches,) and sets its time per batch.
+    int64_t getBestLevel(const uint32_t& bits, const std::string& backend, const int64_t& minLevel,
+        const int64_t& maxLevel, double& batchSeconds) const
+    {
+        int64_t best = -1;
+        batchSeconds = -1.0;
+        for (int64_t level = minLevel; level <= maxLevel; ++level) {
+            const double seconds = getBatchSeconds(bits, backend, level);
+            if ((seconds > 0.0) && ((best < 0) || (seconds < batchSeconds))) {
+                best = level;
+                batchSeconds = seconds;
+            }
+        }
+
+        return best;
+    }
+
+    // Why nothing matched, (for the fallback message)
+    std::string describeMismatch(const std::string& backend) const
+    {
+        if (isLegacy) {
+            return path + " is from an older tuner; run qimcifa_tuner again";
+        }
+        if (entries.empty()) {
+            return "no calibration in " + path + "; run qimcifa_tuner";
+        }
+        const std::string cpu = getCpuModel();
+        bool isCpu = false, isBuild = false;
+        for (const CalibrationEntry& e : entries) {
+            isCpu = isCpu || (e.cpu == cpu);
+            isBuild = isBuild || ((e.cpu == cpu) && (e.options == options));
+        }
+        if (!isCpu) {
+            return "no calibration in " + path + " for this CPU (" + cpu + "); run qimcifa_tuner here";
+        }
+        if (!isBuild) {
+            return "no calibration in " + path + " for these options (" + options +
+                "); run this build's qimcifa_tuner with them";
+        }
+
+        return "no calibration in " + path + " for the " + backend +
+            " backend; run qimcifa_tuner on a number this wide";
+    }
+};
+} // namespace Qimcifa
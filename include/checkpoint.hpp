@@ -0,0 +1,294 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Crash-safe checkpoints of search progress, to resume long runs after a reboot or preemption.
+//
+// Several workers complete batches out of order, so progress is a set of completed intervals of
+// batch (claim) indices, with holes, rather than a single counter. On resume, only the holes are
+// handed out again: the scheduler counts through a "compacted" index space of the batches still
+// pending, which the ledger maps back to real batch indices. Checkpoints are written to a temporary
+// file, synced, and renamed over the last one, (then the directory is synced, to keep the rename,) so
+// a crash at any point leaves a valid checkpoint.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "batch_permutation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Qimcifa {
+
+constexpr double DEFAULT_CHECKPOINT_INTERVAL = 60.0;
+constexpr int CHECKPOINT_VERSION = 2;
+
+// The default checkpoint file, named by a hash of everything a checkpoint must match, so that
+// searches for different numbers, (or batch orders, levels, or node splits,) never share one
+inline std::string getDefaultCheckpointPath(const std::string& number, const std::string& order, const int64_t& level,
+    const size_t& nodeCount, const size_t& nodeId)
+{
+    std::stringstream key;
+    key << number << " " << order << " " << level << " " << nodeCount;
+    std::stringstream ss;
+    ss << "qimcifa_checkpoint_" << std::hex << std::setw(16) << std::setfill('0') << hashKey(key.str(), 0U)
+       << std::dec << "_" << nodeId << ".txt";
+
+    return ss.str();
+}
+
+struct ProgressLedger {
+    const std::string path;
+    // Everything a checkpoint must match, to resume from it
+    const std::string number;
+    // Batch order, ("sequential," or the random order's seed)
+    const std::string order;
+    const int64_t level;
+    const size_t nodeCount;
+    const size_t nodeId;
+    const uint64_t fullTotal;
+    std::chrono::nanoseconds interval;
+    std::mutex ledgerMutex;
+    // Held for a whole save, (file I/O included,) but never while holding "ledgerMutex"
+    std::mutex saveMutex;
+    // Completed batch indices, as disjoint, non-adjacent [start, end) intervals, keyed by start
+    std::map<uint64_t, uint64_t> done;
+    // Batch indices still pending when this run started, as [start, end) intervals, with the count
+    // of pending indices before each, (to map compacted claim indices back to batch indices)
+    std::vector<std::pair<uint64_t, uint64_t>> pending;
+    std::vector<uint64_t> pendingBefore;
+    uint64_t pendingTotal;
+    std::chrono::time_point<std::chrono::high_resolution_clock> lastSave;
+    // Whether "load()" found a file at our path that isn't a checkpoint of this search
+    bool isMismatched;
+
+    ProgressLedger(const std::string& p, const std::string& n, const std::string& o, const int64_t& l,
+        const size_t& nc, const size_t& ni, const uint64_t& t, const double& intervalSeconds)
+        : path(p)
+        , number(n)
+        , order(o)
+        , level(l)
+        , nodeCount(nc)
+        , nodeId(ni)
+        , fullTotal(t)
+        , interval((int64_t)(intervalSeconds * 1e9))
+        , pendingTotal(t)
+        , lastSave(std::chrono::high_resolution_clock::now())
+        , isMismatched(false)
+    {
+        pending.emplace_back(0U, fullTotal);
+        pendingBefore.push_back(0U);
+    }
+
+    // Merge [start, end) into the completed set. (Caller holds the lock.)
+    void merge(uint64_t start, uint64_t end)
+    {
+        auto it = done.upper_bound(start);
+        if (it != done.begin()) {
+            const auto prev = std::prev(it);
+            if (prev->second >= start) {
+                start = prev->first;
+                end = std::max(end, prev->second);
+                it = done.erase(prev);
+            }
+        }
+        while ((it != done.end()) && (it->first <= end)) {
+            end = std::max(end, it->second);
+            it = done.erase(it);
+        }
+        done[start] = end;
+    }
+
+    uint64_t completedCount() const
+    {
+        uint64_t count = 0U;
+        for (const auto& range : done) {
+            count += range.second - range.first;
+        }
+
+        return count;
+    }
+
+    // Load a matching checkpoint, if there is one, and return whether we did. Any other file at our
+    // path, (like a checkpoint for a different number, batch order, level, or node split,) sets
+    // "isMismatched," and must not be overwritten.
+    bool load()
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string key;
+        int version = 0;
+        std::string n, o;
+        int64_t l = -1;
+        size_t nc = 0U, ni = 0U;
+        uint64_t t = 0U;
+        if (!(file >> key >> version) || (key != "qimcifa-checkpoint") || (version != CHECKPOINT_VERSION) ||
+            !(file >> key >> n) || (key != "number") || !(file >> key >> o) || (key != "order") ||
+            !(file >> key >> l) || (key != "level") || !(file >> key >> nc >> ni) || (key != "nodes") ||
+            !(file >> key >> t) || (key != "total")) {
+            isMismatched = true;
+            return false;
+        }
+        if ((n != number) || (o != order) || (l != level) || (nc != nodeCount) || (ni != nodeId) || (t != fullTotal)) {
+            isMismatched = true;
+            return false;
+        }
+
+        uint64_t start, end;
+        while ((file >> key >> start >> end) && (key == "done")) {
+            if ((start < end) && (end <= fullTotal)) {
+                merge(start, end);
+            }
+        }
+
+        // The pending set is the complement of the completed set.
+        pending.clear();
+        pendingBefore.clear();
+        pendingTotal = 0U;
+        uint64_t next = 0U;
+        for (const auto& range : done) {
+            if (range.first > next) {
+                pending.emplace_back(next, range.first);
+                pendingBefore.push_back(pendingTotal);
+                pendingTotal += range.first - next;
+            }
+            next = range.second;
+        }
+        if (next < fullTotal) {
+            pending.emplace_back(next, fullTotal);
+            pendingBefore.push_back(pendingTotal);
+            pendingTotal += fullTotal - next;
+        }
+
+        return true;
+    }
+
+    // Map the i-th pending batch, (in the compacted index space the scheduler hands out,) to its
+    // real batch index. (The pending set is fixed for the run, so this needs no lock.)
+    uint64_t toBatchIndex(const uint64_t& i) const
+    {
+        const size_t r = (size_t)(std::upper_bound(pendingBefore.begin(), pendingBefore.end(), i) -
+                             pendingBefore.begin()) -
+            1U;
+
+        return pending[r].first + (i - pendingBefore[r]);
+    }
+
+    // Sync the directory that holds our path, so that a rename into it survives a crash.
+    bool syncDirectory() const
+    {
+#if defined(__linux__)
+        const size_t slash = path.find_last_of('/');
+        const std::string dir = (slash == std::string::npos) ? "." : (slash ? path.substr(0U, slash) : "/");
+        const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+            return false;
+        }
+        const bool isSynced = !fsync(fd);
+        close(fd);
+
+        return isSynced;
+#else
+        return true;
+#endif
+    }
+
+    // Write a copy of the completed set, atomically replacing the last checkpoint. (Caller holds
+    // "saveMutex," but not "ledgerMutex.")
+    bool write(const std::map<uint64_t, uint64_t>& completed)
+    {
+        std::stringstream ss;
+        ss << "qimcifa-checkpoint " << CHECKPOINT_VERSION << std::endl;
+        ss << "number " << number << std::endl;
+        ss << "order " << order << std::endl;
+        ss << "level " << level << std::endl;
+        ss << "nodes " << nodeCount << " " << nodeId << std::endl;
+        ss << "total " << fullTotal << std::endl;
+        for (const auto& range : completed) {
+            ss << "done " << range.first << " " << range.second << std::endl;
+        }
+        const std::string contents = ss.str();
+
+        const std::string tmpPath = path + ".tmp";
+        std::FILE* file = std::fopen(tmpPath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        bool isWritten = (std::fwrite(contents.data(), 1U, contents.size(), file) == contents.size()) &&
+            !std::fflush(file);
+#if defined(__linux__)
+        isWritten = isWritten && !fsync(fileno(file));
+#endif
+        isWritten = !std::fclose(file) && isWritten;
+        if (!isWritten || std::rename(tmpPath.c_str(), path.c_str())) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        return syncDirectory();
+    }
+
+    // Copy the completed set, and write it, outside the ledger lock. (Caller holds "saveMutex.")
+    bool saveSnapshot()
+    {
+        std::map<uint64_t, uint64_t> completed;
+        {
+            std::lock_guard<std::mutex> lock(ledgerMutex);
+            completed = done;
+            lastSave = std::chrono::high_resolution_clock::now();
+        }
+
+        return write(completed);
+    }
+
+    bool save()
+    {
+        std::lock_guard<std::mutex> lock(saveMutex);
+        return saveSnapshot();
+    }
+
+    // Record one completed batch, and checkpoint if it's been long enough since the last one. (Only
+    // one worker saves at a time, and the others carry on, rather than wait for its disk I/O.)
+    void complete(const uint64_t& batchIndex)
+    {
+        {
+            std::lock_guard<std::mutex> lock(ledgerMutex);
+            merge(batchIndex, batchIndex + 1U);
+            if (!interval.count() || ((std::chrono::high_resolution_clock::now() - lastSave) < interval)) {
+                return;
+            }
+        }
+
+        std::unique_lock<std::mutex> saveLock(saveMutex, std::try_to_lock);
+        if (saveLock.owns_lock()) {
+            saveSnapshot();
+        }
+    }
+
+    // (Once the search is over, there's nothing to resume.)
+    void remove() { std::remove(path.c_str()); }
+};
+} // namespace Qimcifa
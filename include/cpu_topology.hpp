@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// CPU topology, (from Linux sysfs,) for placing worker threads.
+//
+// Left to itself, the OS scheduler migrates workers between cores, (and between sockets,) which
+// costs us cache and memory locality. Instead, we can pin each worker to one logical CPU, either
+// on every hardware (SMT) thread, or on just one thread per physical core. Once pinned, a worker
+// copies anything it reads constantly, (like the wheel table,) so that "first touch" allocates
+// that copy in memory local to the worker's own NUMA node.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Qimcifa {
+
+enum WorkerPlacement { PLACE_DEFAULT = 0, PLACE_PER_CORE = 1, PLACE_PER_THREAD = 2 };
+
+struct CpuInfo {
+    size_t cpu;
+    size_t package;
+    size_t core;
+    size_t node;
+};
+
+// Parse a sysfs CPU (or node) list, like "0-3,8,10-11".
+inline std::vector<size_t> parseCpuList(const std::string& list)
+{
+    std::vector<size_t> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || (range[0] < '0') || (range[0] > '9')) {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const size_t first = std::stoul(range.substr(0U, dash));
+        const size_t last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1U));
+        for (size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+inline bool readSysfsLine(const std::string& path, std::string& line)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::getline(file, line);
+
+    return !line.empty();
+}
+
+inline size_t readSysfsValue(const std::string& path, const size_t& fallback)
+{
+    std::string line;
+    if (!readSysfsLine(path, line)) {
+        return fallback;
+    }
+
+    try {
+        return std::stoul(line);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+// Every online logical CPU that we may run on, with its package, (physical) core, and NUMA node.
+// Without sysfs, we fall back to treating each hardware thread as its own core, on one package and node.
+inline std::vector<CpuInfo> getCpuTopology()
+{
+    const std::string cpuRoot = "/sys/devices/system/cpu/";
+    const std::string nodeRoot = "/sys/devices/system/node/";
+
+    std::string line;
+    std::vector<size_t> cpus;
+    if (readSysfsLine(cpuRoot + "online", line)) {
+        cpus = parseCpuList(line);
+    }
+#if defined(__linux__)
+    // Only the CPUs in our affinity mask, (as narrowed by "taskset" or a cgroup cpuset,) can take a worker.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (!sched_getaffinity(0, sizeof(cpu_set_t), &allowed)) {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                       [&allowed](const size_t& cpu) { return (cpu >= CPU_SETSIZE) || !CPU_ISSET(cpu, &allowed); }),
+            cpus.end());
+    }
+#endif
+    if (cpus.empty()) {
+        const size_t count = std::max(1U, std::thread::hardware_concurrency());
+        for (size_t cpu = 0U; cpu < count; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    std::vector<CpuInfo> topology;
+    topology.reserve(cpus.size());
+    for (const size_t& cpu : cpus) {
+        const std::string path = cpuRoot + "cpu" + std::to_string(cpu) + "/topology/";
+        topology.push_back(
+            CpuInfo{ cpu, readSysfsValue(path + "physical_package_id", 0U), readSysfsValue(path + "core_id", cpu), 0U });
+    }
+
+    if (readSysfsLine(nodeRoot + "online", line)) {
+        for (const size_t& node : parseCpuList(line)) {
+            std::string nodeCpus;
+            if (!readSysfsLine(nodeRoot + "node" + std::to_string(node) + "/cpulist", nodeCpus)) {
+                continue;
+            }
+            for (const size_t& cpu : parseCpuList(nodeCpus)) {
+                for (CpuInfo& info : topology) {
+                    if (info.cpu == cpu) {
+                        info.node = node;
+                    }
+                }
+            }
+        }
+    }
+
+    return topology;
+}
+
+// Logical CPUs to pin workers to, (one worker each,) or empty, to leave placement to the OS.
+// Workers are ordered by NUMA node, then package, then core, so that neighbors share caches.
+inline std::vector<size_t> getWorkerCpus(const WorkerPlacement& placement)
+{
+    std::vector<size_t> workerCpus;
+    if (placement == PLACE_DEFAULT) {
+        return workerCpus;
+    }
+
+    std::vector<CpuInfo> topology = getCpuTopology();
+    std::sort(topology.begin(), topology.end(), [](const CpuInfo& a, const CpuInfo& b) {
+        if (a.node != b.node) {
+            return a.node < b.node;
+        }
+        if (a.package != b.package) {
+            return a.package < b.package;
+        }
+        if (a.core != b.core) {
+            return a.core < b.core;
+        }
+        return a.cpu < b.cpu;
+    });
+
+    std::set<std::pair<size_t, size_t>> cores;
+    for (const CpuInfo& info : topology) {
+        // The first SMT sibling stands for its whole physical core.
+        if ((placement == PLACE_PER_CORE) && !cores.insert(std::make_pair(info.package, info.core)).second) {
+            continue;
+        }
+        workerCpus.push_back(info.cpu);
+    }
+
+    return workerCpus;
+}
+
+// Pin the calling thread to one logical CPU, (if the platform supports it).
+inline bool pinThisThread(const size_t& cpu)
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+
+    return !pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+} // namespace Qimcifa
@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Complete factorization, (rather than the first split,) of a general integer: strip every prime
+// factor below a bound by trial division, then test each cofactor for primality, (by Miller-Rabin,)
+// and hand every composite one back to the factoring engines, (Pollard's rho, for a small factor,
+// or the quadratic sieve,) until only primes are left. Neither engine splits a perfect power of a
+// prime, though, so every composite is first checked for k-th roots, (for each prime "k").
+//
+// Trial division takes the sieve's primes a few at a time: as many as multiply into a 64-bit word
+// share one multiprecision remainder, and each prime only divides that word, so the cost is about
+// one full-width division per three primes, (near 2^20,) and only a hit divides N itself.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "batch_sieve.hpp"
+#include "integer_sqrt.hpp"
+#include "qimcifa.hpp"
+
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Qimcifa {
+
+// Strip the prime factors up to this bound by trial division, by default
+constexpr size_t DEFAULT_STRIP_BOUND = 1U << 20U;
+// Seconds of Pollard's rho for each cofactor, before the quadratic sieve takes over, at the sieve's
+// smallest size. (The sieve's cost grows much faster with size than rho's, for the same factor, so
+// this doubles with every FACTORIZE_RHO_DOUBLING_BITS past that.)
+constexpr double FACTORIZE_RHO_SECONDS = 1.0;
+constexpr double FACTORIZE_RHO_DOUBLING_BITS = 32.0;
+// Miller-Rabin bases: together, (the first 13 primes,) they're a proof of primality below
+// 3.3 * 10^24, (so, for 81 bits or fewer,) and a probable prime test above that.
+constexpr uint32_t PRIME_TEST_BASES[] = { 2U, 3U, 5U, 7U, 11U, 13U, 17U, 19U, 23U, 29U, 31U, 37U, 41U };
+constexpr uint64_t PRIME_TEST_PROOF_BITS = 81U;
+
+// (b^e) mod m, by square and multiply: every product is below m^2, so this needs twice the width of m.
+template <typename BigInteger> BigInteger powMod(BigInteger b, BigInteger e, const BigInteger& m)
+{
+    BigInteger result = 1U;
+    b = b % m;
+    while (e != 0U) {
+        if ((e & 1U) != 0U) {
+            result = (result * b) % m;
+        }
+        b = (b * b) % m;
+        e = e >> 1U;
+    }
+
+    return result;
+}
+
+// Miller-Rabin, (at twice the width of "n")
+template <typename BigInteger> bool isProbablePrime(const BigInteger& n)
+{
+    if (n < 2U) {
+        return false;
+    }
+    for (const uint32_t& base : PRIME_TEST_BASES) {
+        if (n == base) {
+            return true;
+        }
+        if ((n % base) == 0U) {
+            return false;
+        }
+    }
+
+    // n - 1 = d * 2^s, for odd "d"
+    const BigInteger nMinusOne = n - 1U;
+    BigInteger d = nMinusOne;
+    uint64_t s = 0U;
+    while ((d & 1U) == 0U) {
+        d = d >> 1U;
+        ++s;
+    }
+
+    for (const uint32_t& base : PRIME_TEST_BASES) {
+        BigInteger x = powMod((BigInteger)base, d, n);
+        if ((x == 1U) || (x == nMinusOne)) {
+            continue;
+        }
+        bool isWitness = true;
+        for (uint64_t i = 1U; i < s; ++i) {
+            x = (x * x) % n;
+            if (x == nMinusOne) {
+                isWitness = false;
+                break;
+            }
+        }
+        if (isWitness) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The smallest prime "k" for which "n" is a perfect k-th power, (setting "root,") or 0, for none.
+// (Like Miller-Rabin, this runs at twice the width of "n.")
+template <typename BigInteger> uint64_t getPerfectPower(const BigInteger& n, BigInteger& root)
+{
+    // (A root of at least 2 has an exponent of at most log2(n).)
+    for (const uint32_t& k : getPrimesTo(log2(n))) {
+        root = iroot(n, k);
+        if (ipow(root, k) == n) {
+            return k;
+        }
+    }
+
+    return 0U;
+}
+
+struct Factorization {
+    const BigIntegerInput toFactor;
+    // Prime factors, with their multiplicities
+    std::map<BigIntegerInput, size_t> primes;
+    // Composite cofactors that no engine split, (in the time we had)
+    std::vector<BigIntegerInput> composites;
+    // Cofactors too wide for this build to test for primality
+    std::vector<BigIntegerInput> untested;
+
+    Factorization(const BigIntegerInput& n)
+        : toFactor(n)
+    {
+        // Intentionally left blank.
+    }
+
+    void addPrime(const BigIntegerInput& p, const size_t& count = 1U) { primes[p] += count; }
+
+    bool isComplete() const { return composites.empty() && untested.empty(); }
+
+    // Whether any prime factor is only a probable prime, (too wide for the Miller-Rabin bases to prove)
+    bool isProbable() const
+    {
+        for (const auto& p : primes) {
+            if (log2(p.first) >= PRIME_TEST_PROOF_BITS) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // "p1^e1 * p2 * ...," in ascending order of the primes, then "[c]" for each composite and "(c)"
+    // for each untested cofactor
+    std::string str() const
+    {
+        std::stringstream ss;
+        std::string separator;
+        for (const auto& p : primes) {
+            ss << separator << p.first;
+            if (p.second > 1U) {
+                ss << "^" << p.second;
+            }
+            separator = " * ";
+        }
+        for (const BigIntegerInput& c : composites) {
+            ss << separator << "[" << c << "]";
+            separator = " * ";
+        }
+        for (const BigIntegerInput& c : untested) {
+            ss << separator << "(" << c << ")";
+            separator = " * ";
+        }
+
+        return ss.str();
+    }
+};
+
+// Divide out every prime up to "bound," (into "factorization,") and return the cofactor. (Past the
+// square root of the cofactor, there's nothing left to strip, so we stop early.)
+inline BigIntegerInput stripSmallFactors(BigIntegerInput n, const size_t& bound, Factorization& factorization)
+{
+    const std::vector<uint32_t> primes = getPrimesTo(bound);
+    for (size_t i = 0U; i < primes.size();) {
+        // As many primes as fit in one word share one multiprecision remainder.
+        uint64_t product = primes[i];
+        size_t end = i + 1U;
+        while ((end < primes.size()) && (product <= (UINT64_MAX / primes[end]))) {
+            product *= primes[end];
+            ++end;
+        }
+        const uint64_t remainder = (uint64_t)(BigIntegerInput)(n % product);
+        for (; i < end; ++i) {
+            const uint32_t& p = primes[i];
+            if (remainder % p) {
+                continue;
+            }
+            size_t count = 0U;
+            while ((n % p) == 0U) {
+                n = n / p;
+                ++count;
+            }
+            factorization.addPrime(p, count);
+        }
+        const BigIntegerInput last = primes[end - 1U];
+        if (n < (last * last)) {
+            break;
+        }
+    }
+
+    return n;
+}
+} // namespace Qimcifa
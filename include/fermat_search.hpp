@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Fermat's method, for factors close together: step "a" up from the square root of N, until
+// a^2 - N = b^2, and then N = (a - b)(a + b). If the factors differ by "d," this takes about
+// d^2 / (8 sqrt(N)) steps, so keys with carelessly close primes fall in milliseconds, where the
+// trial division search, (down from the square root, one wheel candidate at a time,) could take
+// effectively forever.
+//
+// Most "a" can be rejected without a full square test: a^2 - N must be a square modulo anything.
+// The residues of "a" modulo 64 * 63 * 65 * 11 for which it is a square modulo all four form a
+// wheel of about 2% of all residues, (built once per number,) and each wheel survivor must then
+// also pass a one-word table for each of a few more small primes, (from one 32-bit remainder per
+// round of the wheel,) so only about one in several thousand "a" costs a multiplication and a
+// square root. Workers, (and nodes,) split each round of the wheel by residue class, so they all
+// advance through "a" together, and a time-boxed pre-pass covers the nearest "a" first.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "qimcifa.hpp"
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace Qimcifa {
+
+// A candidate "a" survives the wheel only if a^2 - N is a square modulo each of these (coprime) moduli.
+constexpr uint32_t FERMAT_WHEEL_MODULI[] = { 64U, 63U, 65U, 11U };
+constexpr uint32_t FERMAT_WHEEL_MODULUS = 64U * 63U * 65U * 11U;
+// Wheel survivors must also pass these, (each below 64, so its table is one word, with a product below 2^32).
+constexpr uint32_t FERMAT_FILTER_PRIMES[] = { 17U, 19U, 23U, 29U, 31U, 37U };
+constexpr uint32_t FERMAT_FILTER_MODULUS = 17U * 19U * 23U * 29U * 31U * 37U;
+constexpr size_t FERMAT_FILTER_COUNT = sizeof(FERMAT_FILTER_PRIMES) / sizeof(FERMAT_FILTER_PRIMES[0]);
+
+// For which residues "a," modulo "m," a^2 - N is a square, modulo "m"
+inline std::vector<bool> getFermatResidues(const uint32_t& m, const uint32_t& nResidue)
+{
+    std::vector<bool> isSquare(m, false);
+    for (uint64_t x = 0U; x < m; ++x) {
+        isSquare[(x * x) % m] = true;
+    }
+    std::vector<bool> isAllowed(m);
+    for (uint64_t a = 0U; a < m; ++a) {
+        isAllowed[a] = isSquare[((a * a) + m - nResidue) % m];
+    }
+
+    return isAllowed;
+}
+
+template <typename BigInteger> struct FermatSearch {
+    const BigInteger toFactor;
+    // The smallest "a" to test, (the ceiling of the square root,) and the largest, past which either
+    // a^2 would overflow the integer width, or a - b would be 1
+    BigInteger first;
+    BigInteger last;
+    // Wheel survivors, ascending, modulo FERMAT_WHEEL_MODULUS
+    std::vector<uint32_t> residues;
+    // Bit "r" of word "i" is set if a^2 - N can be a square for "a" of residue "r" modulo the "i"th filter prime.
+    uint64_t filterMasks[FERMAT_FILTER_COUNT];
+    // This node's residue classes are every "nodeCount"th, from "nodeId."
+    size_t nodeCount;
+    size_t nodeId;
+
+    FermatSearch(const BigInteger& n, const size_t& nc, const size_t& nid)
+        : toFactor(n)
+        , nodeCount(nc ? nc : 1U)
+        , nodeId(nid)
+    {
+        first = isqrt(toFactor);
+        if ((first * first) < toFactor) {
+            ++first;
+        }
+        last = (toFactor - 1U) >> 1U;
+        // (Find the largest power of 2 that squares without overflow, if the width is fixed.)
+        BigInteger x = 1U;
+        while (x <= last) {
+            const BigInteger y = x << 1U;
+            if ((y == 0U) || (((y * y) / y) != y)) {
+                if ((y - 1U) <= last) {
+                    last = y - 1U;
+                }
+                break;
+            }
+            x = y;
+        }
+
+        std::vector<std::vector<bool>> wheelTables;
+        for (const uint32_t& m : FERMAT_WHEEL_MODULI) {
+            wheelTables.push_back(getFermatResidues(m, (uint32_t)(toFactor % m)));
+        }
+        for (uint32_t r = 0U; r < FERMAT_WHEEL_MODULUS; ++r) {
+            if (wheelTables[0U][r & 63U] && wheelTables[1U][r % 63U] && wheelTables[2U][r % 65U] &&
+                wheelTables[3U][r % 11U]) {
+                residues.push_back(r);
+            }
+        }
+
+        for (size_t i = 0U; i < FERMAT_FILTER_COUNT; ++i) {
+            const uint32_t& q = FERMAT_FILTER_PRIMES[i];
+            const std::vector<bool> table = getFermatResidues(q, (uint32_t)(toFactor % q));
+            filterMasks[i] = 0U;
+            for (uint32_t r = 0U; r < q; ++r) {
+                filterMasks[i] |= ((uint64_t)table[r]) << r;
+            }
+        }
+    }
+
+    inline bool isFiltered(const uint32_t& aResidue) const
+    {
+        for (size_t i = 0U; i < FERMAT_FILTER_COUNT; ++i) {
+            if (!((filterMasks[i] >> (aResidue % FERMAT_FILTER_PRIMES[i])) & 1U)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Test this worker's residue classes, one round of the wheel at a time, until the scheduler stops.
+    void run(const size_t& worker, const size_t& workerCount, BatchScheduler& scheduler) const
+    {
+        if (residues.empty() || (first > last)) {
+            // (N is even, or too small for this to be worth it.)
+            return;
+        }
+        const size_t stride = nodeCount * (workerCount ? workerCount : 1U);
+        const size_t start = nodeId + nodeCount * worker;
+        for (BigInteger base = first - (first % FERMAT_WHEEL_MODULUS); base <= last; base += FERMAT_WHEEL_MODULUS) {
+            if (scheduler.isStopped()) {
+                return;
+            }
+            const uint64_t baseResidue = (uint64_t)(base % FERMAT_FILTER_MODULUS);
+            for (size_t j = start; j < residues.size(); j += stride) {
+                if (isFiltered((uint32_t)((baseResidue + residues[j]) % FERMAT_FILTER_MODULUS))) {
+                    continue;
+                }
+                const BigInteger a = base + residues[j];
+                if (a < first) {
+                    continue;
+                }
+                if (a > last) {
+                    break;
+                }
+                const BigInteger bSqr = a * a - toFactor;
+                const BigInteger b = isqrt(bSqr);
+                if ((b * b) == bSqr) {
+                    printSuccess<BigInteger>(a - b, a + b, toFactor, "Fermat: Found ", scheduler);
+                    return;
+                }
+            }
+        }
+    }
+};
+
+// Run the search on "workerCount" threads, until it succeeds, runs out of candidates, or "scheduler"
+// stops it, (by its time budget, or an interrupt).
+template <typename BigInteger>
+void runFermatSearch(const BigInteger& toFactor, const size_t& nodeCount, const size_t& nodeId,
+    const unsigned& workerCount, BatchScheduler& scheduler)
+{
+    const FermatSearch<BigInteger> search(toFactor, nodeCount, nodeId);
+    std::vector<std::future<void>> futures;
+    futures.reserve(workerCount);
+    for (unsigned w = 0U; w < workerCount; ++w) {
+        futures.push_back(std::async(std::launch::async, [&search, &scheduler, w, workerCount]() {
+            search.run(w, workerCount, scheduler);
+        }));
+    }
+    for (std::future<void>& future : futures) {
+        future.get();
+    }
+}
+} // namespace Qimcifa
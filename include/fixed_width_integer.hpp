@@ -0,0 +1,533 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Fixed-limb unsigned integers, for the 128-bit to 256-bit rungs of the bit width ladder.
+//
+// Boost's generic cpp_int_backend runs every modulo through general-purpose, variable-length limb
+// loops. At these widths, the limb count is known at compile time, so addition and subtraction
+// reduce to a carry chain (adc/sbb), multiplication to a handful of 64x64->128 products (mul/mulx),
+// and division to Knuth's algorithm D, with one hardware 128/64 "divq" per quotient limb.
+// At 128 bits, we use the compiler's native "unsigned __int128," instead.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace Qimcifa {
+
+inline unsigned char addCarry(unsigned char c, uint64_t a, uint64_t b, uint64_t* out)
+{
+#if defined(__x86_64__)
+    unsigned long long o;
+    c = _addcarry_u64(c, a, b, &o);
+    *out = o;
+    return c;
+#else
+    const unsigned __int128 s = (unsigned __int128)a + b + c;
+    *out = (uint64_t)s;
+    return (unsigned char)(s >> 64U);
+#endif
+}
+
+inline unsigned char subBorrow(unsigned char c, uint64_t a, uint64_t b, uint64_t* out)
+{
+#if defined(__x86_64__)
+    unsigned long long o;
+    c = _subborrow_u64(c, a, b, &o);
+    *out = o;
+    return c;
+#else
+    const unsigned __int128 d = (unsigned __int128)a - b - c;
+    *out = (uint64_t)d;
+    return (unsigned char)((d >> 64U) & 1U);
+#endif
+}
+
+// Full 64x64->128 product, (mul, or mulx with BMI2)
+inline uint64_t mulWide(uint64_t a, uint64_t b, uint64_t* hi)
+{
+    const unsigned __int128 p = (unsigned __int128)a * b;
+    *hi = (uint64_t)(p >> 64U);
+    return (uint64_t)p;
+}
+
+// 128/64 division, with the precondition (hi < d), so the quotient fits in one limb
+inline uint64_t divWide(uint64_t hi, uint64_t lo, uint64_t d, uint64_t* r)
+{
+#if defined(__x86_64__)
+    uint64_t q;
+    __asm__("divq %4" : "=a"(q), "=d"(*r) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+#else
+    const unsigned __int128 n = ((unsigned __int128)hi << 64U) | lo;
+    *r = (uint64_t)(n % d);
+    return (uint64_t)(n / d);
+#endif
+}
+
+template <size_t Limbs> struct FixedWidthUint {
+    static_assert(Limbs > 1U, "Use uint64_t for single-limb integers.");
+
+    uint64_t limbs[Limbs];
+
+    FixedWidthUint()
+    {
+        // Intentionally left blank.
+    }
+
+    FixedWidthUint(uint64_t v)
+    {
+        limbs[0U] = v;
+        for (size_t i = 1U; i < Limbs; ++i) {
+            limbs[i] = 0U;
+        }
+    }
+
+    // From Boost (or GMP) arbitrary precision integers
+    template <typename T, typename std::enable_if<std::is_class<T>::value, int>::type = 0>
+    explicit FixedWidthUint(const T& v)
+    {
+        for (size_t i = 0U; i < Limbs; ++i) {
+            limbs[i] = static_cast<uint64_t>((T)(v >> (64U * i)) & 0xFFFFFFFFFFFFFFFFULL);
+        }
+    }
+
+    // To Boost (or GMP) arbitrary precision integers
+    template <typename T,
+        typename std::enable_if<std::is_class<T>::value && std::is_constructible<T, uint64_t>::value, int>::type = 0,
+        typename = decltype(std::declval<T&>() <<= 64U, std::declval<T&>() |= uint64_t())>
+    explicit operator T() const
+    {
+        T r = limbs[Limbs - 1U];
+        for (size_t i = Limbs - 1U; i > 0U; --i) {
+            r <<= 64U;
+            r |= limbs[i - 1U];
+        }
+        return r;
+    }
+
+    explicit operator uint64_t() const { return limbs[0U]; }
+    explicit operator uint32_t() const { return (uint32_t)limbs[0U]; }
+    explicit operator bool() const { return !isZero(); }
+
+    explicit operator double() const
+    {
+        double r = 0.0;
+        for (size_t i = Limbs; i > 0U; --i) {
+            r = r * 18446744073709551616.0 + (double)limbs[i - 1U];
+        }
+        return r;
+    }
+
+    template <typename T> T convert_to() const { return (T)(*this); }
+
+    inline bool isZero() const
+    {
+        for (size_t i = 0U; i < Limbs; ++i) {
+            if (limbs[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Number of significant limbs
+    inline size_t size() const
+    {
+        size_t n = Limbs;
+        while (n && !limbs[n - 1U]) {
+            --n;
+        }
+        return n;
+    }
+
+    static int compare(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        for (size_t i = Limbs; i > 0U; --i) {
+            if (a.limbs[i - 1U] != b.limbs[i - 1U]) {
+                return (a.limbs[i - 1U] < b.limbs[i - 1U]) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    static void divMod(const FixedWidthUint& u, const FixedWidthUint& v, FixedWidthUint* q, FixedWidthUint* r)
+    {
+        const size_t n = v.size();
+        if (!n) {
+            throw std::domain_error("FixedWidthUint division by zero!");
+        }
+        const size_t m = u.size();
+        if (q) {
+            *q = 0U;
+        }
+        if ((m < n) || (compare(u, v) < 0)) {
+            if (r) {
+                *r = u;
+            }
+            return;
+        }
+
+        if (n == 1U) {
+            // Short division: one divq per limb
+            const uint64_t d = v.limbs[0U];
+            uint64_t rem = 0U;
+            for (size_t i = m; i > 0U; --i) {
+                const uint64_t qi = divWide(rem, u.limbs[i - 1U], d, &rem);
+                if (q) {
+                    q->limbs[i - 1U] = qi;
+                }
+            }
+            if (r) {
+                *r = rem;
+            }
+            return;
+        }
+
+        // Knuth, TAOCP Vol. 2, 4.3.1, Algorithm D, with 64-bit digits
+        const int s = __builtin_clzll(v.limbs[n - 1U]);
+        uint64_t vn[Limbs];
+        uint64_t un[Limbs + 1U];
+        for (size_t i = n - 1U; i > 0U; --i) {
+            vn[i] = s ? ((v.limbs[i] << s) | (v.limbs[i - 1U] >> (64 - s))) : v.limbs[i];
+        }
+        vn[0U] = v.limbs[0U] << s;
+        un[m] = s ? (u.limbs[m - 1U] >> (64 - s)) : 0U;
+        for (size_t i = m - 1U; i > 0U; --i) {
+            un[i] = s ? ((u.limbs[i] << s) | (u.limbs[i - 1U] >> (64 - s))) : u.limbs[i];
+        }
+        un[0U] = u.limbs[0U] << s;
+
+        for (size_t j = m - n + 1U; j > 0U;) {
+            --j;
+
+            // Estimate the quotient limb from the top two limbs.
+            uint64_t qhat, rhat;
+            bool isRhatOverflow = false;
+            if (un[j + n] >= vn[n - 1U]) {
+                qhat = 0xFFFFFFFFFFFFFFFFULL;
+                isRhatOverflow = addCarry(0U, un[j + n - 1U], vn[n - 1U], &rhat);
+            } else {
+                qhat = divWide(un[j + n], un[j + n - 1U], vn[n - 1U], &rhat);
+            }
+            while (!isRhatOverflow) {
+                uint64_t pHi;
+                const uint64_t pLo = mulWide(qhat, vn[n - 2U], &pHi);
+                if ((pHi < rhat) || ((pHi == rhat) && (pLo <= un[j + n - 2U]))) {
+                    break;
+                }
+                --qhat;
+                isRhatOverflow = addCarry(0U, rhat, vn[n - 1U], &rhat);
+            }
+
+            // Multiply and subtract.
+            uint64_t mulCarry = 0U;
+            unsigned char borrow = 0U;
+            for (size_t i = 0U; i < n; ++i) {
+                uint64_t pHi;
+                const uint64_t pLo = mulWide(qhat, vn[i], &pHi);
+                uint64_t pLoC;
+                pHi += addCarry(0U, pLo, mulCarry, &pLoC);
+                borrow = subBorrow(borrow, un[i + j], pLoC, &un[i + j]);
+                mulCarry = pHi;
+            }
+            borrow = subBorrow(borrow, un[j + n], mulCarry, &un[j + n]);
+
+            if (borrow) {
+                // Add back. (This happens with probability ~2/2^64.)
+                --qhat;
+                unsigned char c = 0U;
+                for (size_t i = 0U; i < n; ++i) {
+                    c = addCarry(c, un[i + j], vn[i], &un[i + j]);
+                }
+                addCarry(c, un[j + n], 0U, &un[j + n]);
+            }
+
+            if (q) {
+                q->limbs[j] = qhat;
+            }
+        }
+
+        if (r) {
+            *r = 0U;
+            for (size_t i = 0U; i < (n - 1U); ++i) {
+                r->limbs[i] = s ? ((un[i] >> s) | (un[i + 1U] << (64 - s))) : un[i];
+            }
+            r->limbs[n - 1U] = un[n - 1U] >> s;
+        }
+    }
+
+    friend FixedWidthUint operator+(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        unsigned char c = 0U;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            c = addCarry(c, a.limbs[i], b.limbs[i], &r.limbs[i]);
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator-(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        unsigned char c = 0U;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            c = subBorrow(c, a.limbs[i], b.limbs[i], &r.limbs[i]);
+        }
+        return r;
+    }
+
+    // Truncated (modulo 2^(64 * Limbs)) product
+    friend FixedWidthUint operator*(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r = 0U;
+        const size_t an = a.size();
+        const size_t bn = b.size();
+        for (size_t i = 0U; i < an; ++i) {
+            uint64_t carry = 0U;
+            for (size_t j = 0U; (j < bn) && ((i + j) < Limbs); ++j) {
+                uint64_t hi;
+                const uint64_t lo = mulWide(a.limbs[i], b.limbs[j], &hi);
+                hi += addCarry(0U, lo, r.limbs[i + j], &r.limbs[i + j]);
+                hi += addCarry(0U, r.limbs[i + j], carry, &r.limbs[i + j]);
+                carry = hi;
+            }
+            if ((i + bn) < Limbs) {
+                r.limbs[i + bn] = carry;
+            }
+        }
+        return r;
+    }
+
+    // Single-word multiplier, (one pass of limb-by-word products)
+    friend FixedWidthUint operator*(const FixedWidthUint& a, const uint64_t& b)
+    {
+        FixedWidthUint r;
+        uint64_t carry = 0U;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            uint64_t hi;
+            const uint64_t lo = mulWide(a.limbs[i], b, &hi);
+            hi += addCarry(0U, lo, carry, &r.limbs[i]);
+            carry = hi;
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator/(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint q;
+        divMod(a, b, &q, nullptr);
+        return q;
+    }
+
+    friend FixedWidthUint operator%(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        divMod(a, b, nullptr, &r);
+        return r;
+    }
+
+    friend FixedWidthUint operator<<(const FixedWidthUint& a, const size_t& b)
+    {
+        FixedWidthUint r = 0U;
+        const size_t w = b >> 6U;
+        const size_t s = b & 63U;
+        for (size_t i = Limbs; i > w; --i) {
+            const size_t d = i - 1U;
+            r.limbs[d] = a.limbs[d - w] << s;
+            if (s && (d > w)) {
+                r.limbs[d] |= a.limbs[d - w - 1U] >> (64U - s);
+            }
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator>>(const FixedWidthUint& a, const size_t& b)
+    {
+        FixedWidthUint r = 0U;
+        const size_t w = b >> 6U;
+        const size_t s = b & 63U;
+        for (size_t i = 0U; (i + w) < Limbs; ++i) {
+            r.limbs[i] = a.limbs[i + w] >> s;
+            if (s && ((i + w + 1U) < Limbs)) {
+                r.limbs[i] |= a.limbs[i + w + 1U] << (64U - s);
+            }
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator&(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            r.limbs[i] = a.limbs[i] & b.limbs[i];
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator|(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            r.limbs[i] = a.limbs[i] | b.limbs[i];
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator^(const FixedWidthUint& a, const FixedWidthUint& b)
+    {
+        FixedWidthUint r;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            r.limbs[i] = a.limbs[i] ^ b.limbs[i];
+        }
+        return r;
+    }
+
+    friend FixedWidthUint operator~(const FixedWidthUint& a)
+    {
+        FixedWidthUint r;
+        for (size_t i = 0U; i < Limbs; ++i) {
+            r.limbs[i] = ~a.limbs[i];
+        }
+        return r;
+    }
+
+    friend bool operator!(const FixedWidthUint& a) { return a.isZero(); }
+
+    friend bool operator==(const FixedWidthUint& a, const FixedWidthUint& b) { return !compare(a, b); }
+    friend bool operator!=(const FixedWidthUint& a, const FixedWidthUint& b) { return compare(a, b) != 0; }
+    friend bool operator<(const FixedWidthUint& a, const FixedWidthUint& b) { return compare(a, b) < 0; }
+    friend bool operator<=(const FixedWidthUint& a, const FixedWidthUint& b) { return compare(a, b) <= 0; }
+    friend bool operator>(const FixedWidthUint& a, const FixedWidthUint& b) { return compare(a, b) > 0; }
+    friend bool operator>=(const FixedWidthUint& a, const FixedWidthUint& b) { return compare(a, b) >= 0; }
+
+    FixedWidthUint& operator+=(const FixedWidthUint& b) { return *this = *this + b; }
+    FixedWidthUint& operator-=(const FixedWidthUint& b) { return *this = *this - b; }
+    FixedWidthUint& operator*=(const FixedWidthUint& b) { return *this = *this * b; }
+    FixedWidthUint& operator/=(const FixedWidthUint& b) { return *this = *this / b; }
+    FixedWidthUint& operator%=(const FixedWidthUint& b) { return *this = *this % b; }
+    FixedWidthUint& operator&=(const FixedWidthUint& b) { return *this = *this & b; }
+    FixedWidthUint& operator|=(const FixedWidthUint& b) { return *this = *this | b; }
+    FixedWidthUint& operator^=(const FixedWidthUint& b) { return *this = *this ^ b; }
+    FixedWidthUint& operator<<=(const size_t& b) { return *this = *this << b; }
+    FixedWidthUint& operator>>=(const size_t& b) { return *this = *this >> b; }
+
+    FixedWidthUint& operator++()
+    {
+        for (size_t i = 0U; i < Limbs; ++i) {
+            if (++limbs[i]) {
+                break;
+            }
+        }
+        return *this;
+    }
+
+    FixedWidthUint& operator--()
+    {
+        for (size_t i = 0U; i < Limbs; ++i) {
+            if (limbs[i]--) {
+                break;
+            }
+        }
+        return *this;
+    }
+
+    FixedWidthUint operator++(int)
+    {
+        const FixedWidthUint r = *this;
+        ++(*this);
+        return r;
+    }
+
+    FixedWidthUint operator--(int)
+    {
+        const FixedWidthUint r = *this;
+        --(*this);
+        return r;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, FixedWidthUint b)
+    {
+        if (b.isZero()) {
+            return os << "0";
+        }
+
+        // Peel off 19 decimal digits at a time.
+        constexpr uint64_t TEN_19 = 10000000000000000000ULL;
+        std::string digits;
+        while (!b.isZero()) {
+            FixedWidthUint q, r;
+            divMod(b, TEN_19, &q, &r);
+            b = q;
+            std::string chunk = std::to_string(r.limbs[0U]);
+            if (!b.isZero()) {
+                chunk = std::string(19U - chunk.size(), '0') + chunk;
+            }
+            digits = chunk + digits;
+        }
+
+        return os << digits;
+    }
+
+    friend std::istream& operator>>(std::istream& is, FixedWidthUint& b)
+    {
+        std::string digits;
+        is >> digits;
+        b = 0U;
+        for (const char& c : digits) {
+            if ((c < '0') || (c > '9')) {
+                is.setstate(std::ios::failbit);
+                break;
+            }
+            b = b * 10U + (uint64_t)(c - '0');
+        }
+        return is;
+    }
+};
+
+typedef FixedWidthUint<3U> uint192_t;
+typedef FixedWidthUint<4U> uint256_t;
+
+// Streaming for the native 128-bit integer, which the standard library lacks
+inline std::ostream& operator<<(std::ostream& os, unsigned __int128 b)
+{
+    constexpr uint64_t TEN_19 = 10000000000000000000ULL;
+    if (b < TEN_19) {
+        return os << (uint64_t)b;
+    }
+    const std::string lo = std::to_string((uint64_t)(b % TEN_19));
+    operator<<(os, b / TEN_19);
+
+    return os << std::string(19U - lo.size(), '0') << lo;
+}
+
+inline std::istream& operator>>(std::istream& is, unsigned __int128& b)
+{
+    std::string digits;
+    is >> digits;
+    b = 0U;
+    for (const char& c : digits) {
+        if ((c < '0') || (c > '9')) {
+            is.setstate(std::ios::failbit);
+            break;
+        }
+        b = b * 10U + (unsigned)(c - '0');
+    }
+    return is;
+}
+} // namespace Qimcifa
@@ -0,0 +1,308 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Linear algebra over GF(2), for congruence of squares: each relation (a row) is the set of factor
+// base primes (columns) that it holds to an odd power, and any set of rows whose columns cancel in
+// pairs, (a "dependency,") multiplies out to a perfect square. With more rows than columns, there
+// must be dependencies, and we find them in two stages:
+//
+// - Filtering, on the sparse rows: a row with a column that no other row has, (a "singleton,") can
+//   never be in a dependency, so we drop it, (which can make more singletons). While the excess of
+//   rows over columns is well beyond what we need, pairs of rows sharing a column of weight 2,
+//   (the simplest "cliques,") are dropped too. Then each column of weight GF2_MERGE_WEIGHT or less
+//   is eliminated, by adding its lightest row to the others and dropping it. Every such merge
+//   shrinks the matrix by one row and one column, and the extra fill costs far less than the
+//   (cubic) dense stage saves.
+// - Gaussian elimination, on what's left, bit-packed into 64-bit words, with each row carrying the
+//   (bit-packed) set of filtered rows that it's the sum of. Each pivot is added to the rows after it
+//   on all workers, and every row that ends up empty holds a dependency.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "qimcifa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace Qimcifa {
+
+// Merge away columns of up to this many rows, before elimination.
+constexpr size_t GF2_MERGE_WEIGHT = 16U;
+// Keep at least this many more rows than columns, (for enough dependencies,) when removing cliques.
+constexpr size_t GF2_TARGET_EXCESS = 64U;
+// Add a pivot on all workers, only when it touches at least this many words.
+constexpr size_t GF2_PARALLEL_WORDS = 1U << 16U;
+
+struct Gf2Matrix {
+    size_t columnCount;
+    // Columns with an odd entry, ascending, per row
+    std::vector<std::vector<uint32_t>> rows;
+    // Matrix size after filtering, (for reporting)
+    size_t filteredRows;
+    size_t filteredColumns;
+
+    Gf2Matrix(const size_t& c)
+        : columnCount(c)
+        , filteredRows(0U)
+        , filteredColumns(0U)
+    {
+        // Intentionally left blank.
+    }
+
+    // Add a row from its entries, (with repeats, in any order,) keeping only those of odd multiplicity.
+    void addRow(std::vector<uint32_t> entries)
+    {
+        std::sort(entries.begin(), entries.end());
+        std::vector<uint32_t> odd;
+        for (size_t i = 0U; i < entries.size();) {
+            size_t j = i;
+            while ((j < entries.size()) && (entries[j] == entries[i])) {
+                ++j;
+            }
+            if ((j - i) & 1U) {
+                odd.push_back(entries[i]);
+            }
+            i = j;
+        }
+        rows.push_back(odd);
+    }
+
+    // The sum of two sorted column sets
+    static std::vector<uint32_t> add(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+    {
+        std::vector<uint32_t> sum;
+        sum.reserve(a.size() + b.size());
+        std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(sum));
+
+        return sum;
+    }
+
+    // Up to "maxCount" dependencies, each a set of row indices, (or none, if "scheduler" stops us first)
+    std::vector<std::vector<uint32_t>> findDependencies(
+        const unsigned& workerCount, const size_t& maxCount, BatchScheduler& scheduler)
+    {
+        // Each filtered row is a sum of original rows.
+        std::vector<std::vector<uint32_t>> parity = rows;
+        std::vector<std::vector<uint32_t>> members(rows.size());
+        std::vector<bool> isActive(rows.size(), true);
+        for (size_t r = 0U; r < rows.size(); ++r) {
+            members[r].push_back((uint32_t)r);
+        }
+
+        std::vector<uint32_t> weights(columnCount);
+        std::vector<std::vector<uint32_t>> columnRows(columnCount);
+        size_t activeRows = 0U, activeColumns = 0U;
+        for (bool isChanged = true; isChanged;) {
+            isChanged = false;
+            std::fill(weights.begin(), weights.end(), 0U);
+            activeRows = 0U;
+            for (size_t r = 0U; r < parity.size(); ++r) {
+                if (isActive[r]) {
+                    ++activeRows;
+                    for (const uint32_t& c : parity[r]) {
+                        ++weights[c];
+                    }
+                }
+            }
+            activeColumns = (size_t)std::count_if(weights.begin(), weights.end(), [](const uint32_t& w) { return w; });
+
+            // Singletons
+            for (size_t r = 0U; r < parity.size(); ++r) {
+                if (isActive[r] &&
+                    std::any_of(parity[r].begin(), parity[r].end(), [&weights](const uint32_t& c) {
+                        return weights[c] == 1U;
+                    })) {
+                    isActive[r] = false;
+                    isChanged = true;
+                }
+            }
+            if (isChanged) {
+                continue;
+            }
+
+            // Rows of light columns, (for cliques and merges)
+            for (size_t c = 0U; c < columnCount; ++c) {
+                columnRows[c].clear();
+            }
+            for (size_t r = 0U; r < parity.size(); ++r) {
+                if (isActive[r]) {
+                    for (const uint32_t& c : parity[r]) {
+                        if (weights[c] <= GF2_MERGE_WEIGHT) {
+                            columnRows[c].push_back((uint32_t)r);
+                        }
+                    }
+                }
+            }
+            // (Each row changes at most once per round, so the weights stay valid.)
+            std::vector<bool> isTouched(parity.size(), false);
+            const auto isFree = [&isTouched](const std::vector<uint32_t>& rs) {
+                return std::none_of(rs.begin(), rs.end(), [&isTouched](const uint32_t& r) { return isTouched[r]; });
+            };
+
+            // Cliques
+            for (size_t c = 0U; (c < columnCount) && (activeRows > (activeColumns + GF2_TARGET_EXCESS)); ++c) {
+                if ((weights[c] != 2U) || !isFree(columnRows[c])) {
+                    continue;
+                }
+                for (const uint32_t& r : columnRows[c]) {
+                    isActive[r] = false;
+                    isTouched[r] = true;
+                }
+                // (At least one column goes with them.)
+                activeRows -= 2U;
+                --activeColumns;
+                isChanged = true;
+            }
+            if (isChanged) {
+                continue;
+            }
+
+            // Merges
+            for (size_t c = 0U; c < columnCount; ++c) {
+                const std::vector<uint32_t>& rs = columnRows[c];
+                if ((weights[c] < 2U) || (weights[c] > GF2_MERGE_WEIGHT) || !isFree(rs)) {
+                    continue;
+                }
+                const uint32_t pivot = *std::min_element(rs.begin(), rs.end(),
+                    [&parity](const uint32_t& a, const uint32_t& b) { return parity[a].size() < parity[b].size(); });
+                for (const uint32_t& r : rs) {
+                    isTouched[r] = true;
+                    if (r == pivot) {
+                        continue;
+                    }
+                    parity[r] = add(parity[r], parity[pivot]);
+                    members[r].insert(members[r].end(), members[pivot].begin(), members[pivot].end());
+                }
+                isActive[pivot] = false;
+                isChanged = true;
+            }
+        }
+        filteredRows = activeRows;
+        filteredColumns = activeColumns;
+
+        // Number the rows and columns that are left.
+        std::vector<uint32_t> denseRows;
+        for (size_t r = 0U; r < parity.size(); ++r) {
+            if (isActive[r]) {
+                denseRows.push_back((uint32_t)r);
+            }
+        }
+        std::vector<uint32_t> denseColumn(columnCount, 0U);
+        size_t columns = 0U;
+        for (size_t c = 0U; c < columnCount; ++c) {
+            if (weights[c]) {
+                denseColumn[c] = (uint32_t)(columns++);
+            }
+        }
+        const size_t n = denseRows.size();
+        if (n <= columns) {
+            return std::vector<std::vector<uint32_t>>();
+        }
+
+        // Each row is its columns, then the rows it's a sum of.
+        const size_t columnWords = (columns + 63U) >> 6U;
+        const size_t words = columnWords + ((n + 63U) >> 6U);
+        std::vector<uint64_t> matrix(n * words, 0U);
+        for (size_t i = 0U; i < n; ++i) {
+            uint64_t* row = &matrix[i * words];
+            for (const uint32_t& c : parity[denseRows[i]]) {
+                row[denseColumn[c] >> 6U] |= 1ULL << (denseColumn[c] & 63U);
+            }
+            row[columnWords + (i >> 6U)] |= 1ULL << (i & 63U);
+        }
+
+        const auto addPivot = [&matrix, &words](const uint64_t* pivot, const size_t& column, const size_t& begin,
+                                  const size_t& end) {
+            const size_t word = column >> 6U;
+            const uint64_t bit = 1ULL << (column & 63U);
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t* row = &matrix[i * words];
+                if (row[word] & bit) {
+                    // (The pivot has no columns before this one.)
+                    for (size_t w = word; w < words; ++w) {
+                        row[w] ^= pivot[w];
+                    }
+                }
+            }
+        };
+        std::vector<uint64_t> pivotRow(words);
+        size_t rank = 0U;
+        for (size_t column = 0U; (column < columns) && (rank < n); ++column) {
+            if (!(column & 63U) && scheduler.isStopped()) {
+                return std::vector<std::vector<uint32_t>>();
+            }
+            const size_t word = column >> 6U;
+            const uint64_t bit = 1ULL << (column & 63U);
+            size_t p = rank;
+            while ((p < n) && !(matrix[p * words + word] & bit)) {
+                ++p;
+            }
+            if (p == n) {
+                continue;
+            }
+            if (p != rank) {
+                std::swap_ranges(matrix.begin() + p * words, matrix.begin() + (p + 1U) * words,
+                    matrix.begin() + rank * words);
+            }
+            std::copy(matrix.begin() + rank * words, matrix.begin() + (rank + 1U) * words, pivotRow.begin());
+            ++rank;
+
+            const size_t rowsLeft = n - rank;
+            if ((workerCount < 2U) || ((rowsLeft * (words - word)) < GF2_PARALLEL_WORDS)) {
+                addPivot(pivotRow.data(), column, rank, n);
+                continue;
+            }
+            const size_t chunk = (rowsLeft + workerCount - 1U) / workerCount;
+            std::vector<std::future<void>> futures;
+            futures.reserve(workerCount);
+            for (size_t begin = rank; begin < n; begin += chunk) {
+                const size_t end = std::min(n, begin + chunk);
+                futures.push_back(std::async(std::launch::async, [&addPivot, &pivotRow, column, begin, end]() {
+                    addPivot(pivotRow.data(), column, begin, end);
+                }));
+            }
+            for (std::future<void>& future : futures) {
+                future.get();
+            }
+        }
+
+        // Every row past the rank is now empty, and a dependency.
+        std::vector<std::vector<uint32_t>> dependencies;
+        for (size_t i = rank; (i < n) && (dependencies.size() < maxCount); ++i) {
+            const uint64_t* row = &matrix[i * words + columnWords];
+            std::vector<uint32_t> sum;
+            for (size_t j = 0U; j < n; ++j) {
+                if ((row[j >> 6U] >> (j & 63U)) & 1U) {
+                    const std::vector<uint32_t>& m = members[denseRows[j]];
+                    sum.insert(sum.end(), m.begin(), m.end());
+                }
+            }
+            // (A merge can add one row into several others, so keep only the rows summed an odd number of times.)
+            std::sort(sum.begin(), sum.end());
+            std::vector<uint32_t> dependency;
+            for (size_t j = 0U; j < sum.size();) {
+                size_t k = j;
+                while ((k < sum.size()) && (sum[k] == sum[j])) {
+                    ++k;
+                }
+                if ((k - j) & 1U) {
+                    dependency.push_back(sum[j]);
+                }
+                j = k;
+            }
+            if (!dependency.empty()) {
+                dependencies.push_back(dependency);
+            }
+        }
+
+        return dependencies;
+    }
+};
+} // namespace Qimcifa
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Integer square root, (the floor,) for every integer type we factor with: native words, the fixed
+// limb types, Boost and GMP, and the pure language "BigInteger."
+//
+// Bisection costs one full-width multiplication per bit of the root, (thousands, at 8192 bits).
+// Instead, we recurse on the top half of the bits, (as in Zimmermann's "Karatsuba square root,")
+// down to 52 bits or fewer, which a double root gets exactly, (after a +/-1 correction,) so exact
+// squares that small never see a division. On the way back up, the root of the top half, (scaled
+// up, and plus one,) is an upper bound with about a quarter of the bits right, so a single Newton
+// step, (one division, at this level's width,) leaves us at the floor or one above it, and one
+// multiplication decides which. Each level is a quarter the cost of the one above it, so the
+// whole root costs not much more than one full-width division.
+//
+// Higher roots, (for perfect power checks,) start from a double precision estimate instead, good to
+// about 50 bits, so that Newton's method only needs a few steps from there, each with one division.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "config.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if USE_GMP
+#include <boost/multiprecision/gmp.hpp>
+#elif USE_BOOST
+#include <boost/multiprecision/cpp_int.hpp>
+#else
+#include "big_integer.hpp"
+#endif
+
+namespace Qimcifa {
+
+// Below this many bits, a double holds the integer exactly, and its root to within one.
+constexpr uint64_t ISQRT_DOUBLE_BITS = 52U;
+
+// Index of the highest set bit, (or 0, for 0 and 1)
+template <typename BigInteger> inline uint64_t log2(BigInteger n)
+{
+    uint64_t pow = 0U;
+    // (Whole words first, so this costs one shift per word, rather than one per bit)
+    for (BigInteger high = (n >> 32U) >> 32U; high != 0U; high = (n >> 32U) >> 32U) {
+        n = high;
+        pow += 64U;
+    }
+    for (uint64_t word = ((uint64_t)n) >> 1U; word; word >>= 1U) {
+        ++pow;
+    }
+
+    return pow;
+}
+
+#if USE_GMP || USE_BOOST
+template <typename Backend, boost::multiprecision::expression_template_option ExpressionTemplates>
+inline uint64_t log2(const boost::multiprecision::number<Backend, ExpressionTemplates>& n)
+{
+    return (n == 0U) ? 0U : (uint64_t)boost::multiprecision::msb(n);
+}
+#else
+inline uint64_t log2(const BigInteger& n) { return (uint64_t)bi_log2(n); }
+#endif
+
+// Floor of the square root
+template <typename BigInteger> BigInteger isqrt(const BigInteger& n)
+{
+    const uint64_t bits = log2(n) + 1U;
+    if (bits <= ISQRT_DOUBLE_BITS) {
+        const uint64_t v = (uint64_t)n;
+        uint64_t root = (uint64_t)std::sqrt((double)v);
+        while ((root * root) > v) {
+            --root;
+        }
+        while (((root + 1U) * (root + 1U)) <= v) {
+            ++root;
+        }
+
+        return (BigInteger)root;
+    }
+
+    // The top (bits - 2h) bits have a root accurate to (at most) 2^h, relative to our own, and (2h)
+    // is at most half our width, less 2, so that one Newton step squares its error to below 1.
+    const uint64_t h = (bits - 4U) >> 2U;
+    const BigInteger x = (isqrt((BigInteger)(n >> (uint32_t)(h << 1U))) + 1U) << (uint32_t)h;
+    // ((x + N / x) / 2 is never below the root, by the AM-GM inequality.)
+    BigInteger y = (x + n / x) >> 1U;
+    while (true) {
+        const BigInteger sqr = y * y;
+        // (A fixed width can only wrap for the floor plus 1, squaring exactly to 2^width, hence 0.)
+        if (!((n < sqr) || (sqr < y))) {
+            return y;
+        }
+        y = y - 1U;
+    }
+}
+
+// b^e, by square and multiply
+template <typename BigInteger> BigInteger ipow(BigInteger b, uint64_t e)
+{
+    BigInteger result = 1U;
+    while (e) {
+        if (e & 1U) {
+            result = result * b;
+        }
+        e >>= 1U;
+        if (e) {
+            b = b * b;
+        }
+    }
+
+    return result;
+}
+
+// Floor of the k-th root, (k >= 2). Along the way, this raises numbers near the root to the power
+// (k - 1), which can reach 2^k times "n," so it needs a type with that much headroom, (as twice the
+// width of "n" has, for any "k" up to its bits).
+template <typename BigInteger> BigInteger iroot(const BigInteger& n, const uint64_t& k)
+{
+    if (k == 2U) {
+        return isqrt(n);
+    }
+    const uint64_t bits = log2(n) + 1U;
+    if (bits <= k) {
+        // (The root is below 2.)
+        return (n == 0U) ? (BigInteger)0U : (BigInteger)1U;
+    }
+
+    // log2(n), from the top 64 bits, then 2^(log2(n) / k), with its top 52 bits from a double
+    const uint64_t shift = (bits > 64U) ? (bits - 64U) : 0U;
+    const double e = (std::log2((double)(uint64_t)(n >> (uint32_t)shift)) + (double)shift) / (double)k;
+    const uint64_t scale = (e > (double)ISQRT_DOUBLE_BITS) ? ((uint64_t)e - ISQRT_DOUBLE_BITS) : 0U;
+    BigInteger x = ((BigInteger)((uint64_t)std::exp2(e - (double)scale) + 1U)) << (uint32_t)scale;
+
+    // One Newton step, from any start, lands at or above the floor, (by the AM-GM inequality,) and
+    // from there, each step decreases until the floor.
+    const BigInteger kMinusOne = (BigInteger)(k - 1U);
+    const BigInteger kBig = (BigInteger)k;
+    BigInteger y = (kMinusOne * x + n / ipow(x, k - 1U)) / kBig;
+    do {
+        x = y;
+        y = (kMinusOne * x + n / ipow(x, k - 1U)) / kBig;
+    } while (y < x);
+
+    return x;
+}
+} // namespace Qimcifa
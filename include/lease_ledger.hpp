@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Dynamic work sharing between nodes, through nothing but a shared directory.
+//
+// Instead of a static split by node count, the batch range is cut into fixed "chunks," and nodes
+// lease them one at a time, by exclusive file creation, (which is atomic on local file systems, and
+// on NFS v3 and later). A node renews its lease by touching the lease file; a lease untouched for
+// longer than its time-to-live is considered abandoned, and the first node to move it aside, (by
+// an atomic rename,) can lease that chunk again. Finished chunks leave a "done" marker, and a
+// success leaves a "found" marker, with the result, which stops every other node at its next poll.
+// So, fast nodes simply take more chunks, and a failed node's chunks are picked up after it stops
+// renewing them. (Lease expiry assumes roughly synchronized clocks between nodes and file server.
+// A stolen lease that was only slow, not abandoned, costs duplicated work, never missed work.)
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Qimcifa {
+
+constexpr double DEFAULT_LEASE_TTL = 60.0;
+// Target count of chunks, when the chunk size is left to us
+constexpr uint64_t DEFAULT_LEASE_CHUNKS = 1024U;
+
+struct SharedLeaseLedger {
+    const std::string dir;
+    const std::string owner;
+    // (Seconds)
+    const double ttl;
+    uint64_t total;
+    uint64_t chunkSize;
+    uint64_t chunkCount;
+    // Next chunk to try, on the first pass through the range
+    uint64_t cursor;
+
+    SharedLeaseLedger(const std::string& d, const double& t)
+        : dir(d)
+        , owner(makeOwner())
+        , ttl(t)
+        , total(0U)
+        , chunkSize(1U)
+        , chunkCount(0U)
+        , cursor(0U)
+    {
+        // Intentionally left blank.
+    }
+
+    static std::string makeOwner()
+    {
+        char host[256] = { 0 };
+        if (gethostname(host, sizeof(host) - 1U)) {
+            host[0] = 0;
+        }
+
+        return std::string(host) + ":" + std::to_string(getpid());
+    }
+
+    std::string markerPath(const std::string& name) const { return dir + "/" + name; }
+    std::string markerPath(const std::string& name, const uint64_t& chunk) const
+    {
+        return dir + "/" + name + "." + std::to_string(chunk);
+    }
+
+    static bool exists(const std::string& path)
+    {
+        struct stat st;
+        return !stat(path.c_str(), &st);
+    }
+
+    static bool readAll(const std::string& path, std::string& contents)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        contents = ss.str();
+
+        return true;
+    }
+
+    // Atomically create "path," failing if it already exists.
+    static bool createExclusive(const std::string& path, const std::string& contents)
+    {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        const bool isWritten = write(fd, contents.data(), contents.size()) == (ssize_t)contents.size();
+        close(fd);
+
+        return isWritten;
+    }
+
+    // Join (or start) the shared job. Every node must describe the same job, (number, order, level,
+    // and batch total,) and every node uses the chunk size of whichever node started it.
+    bool join(const std::string& description, const uint64_t& t, const uint64_t& requestedChunk, std::string& error)
+    {
+        total = t;
+        const uint64_t autoChunk = (total + DEFAULT_LEASE_CHUNKS - 1U) / DEFAULT_LEASE_CHUNKS;
+        const uint64_t chunk = requestedChunk ? requestedChunk : (autoChunk ? autoChunk : 1U);
+        const std::string jobPath = markerPath("job");
+        // (Write the whole description first, then publish it atomically, so no node reads half of it.)
+        const std::string tmpPath = markerPath("job.tmp." + owner);
+        std::remove(tmpPath.c_str());
+        if (createExclusive(tmpPath, description + "chunk " + std::to_string(chunk) + "\n")) {
+            const bool isFirst = !link(tmpPath.c_str(), jobPath.c_str());
+            std::remove(tmpPath.c_str());
+            if (isFirst) {
+                chunkSize = chunk;
+                chunkCount = (total + chunkSize - 1U) / chunkSize;
+                return true;
+            }
+        }
+
+        std::string contents;
+        if (!readAll(jobPath, contents)) {
+            error = "Could not create or read " + jobPath;
+            return false;
+        }
+        const size_t chunkPos = contents.rfind("chunk ");
+        if ((chunkPos == std::string::npos) || (contents.substr(0U, chunkPos) != description)) {
+            error = "Shared directory " + dir + " holds a different job";
+            return false;
+        }
+        chunkSize = std::stoull(contents.substr(chunkPos + 6U));
+        chunkSize = chunkSize ? chunkSize : 1U;
+        chunkCount = (total + chunkSize - 1U) / chunkSize;
+
+        return true;
+    }
+
+    bool isExpired(const std::string& path) const
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st)) {
+            // (Gone already, so there's nothing to wait for.)
+            return true;
+        }
+
+        return difftime(time(nullptr), st.st_mtime) > ttl;
+    }
+
+    bool isOwned(const uint64_t& chunk) const
+    {
+        std::string contents;
+        return readAll(markerPath("lease", chunk), contents) && (contents == owner);
+    }
+
+    bool isDone(const uint64_t& chunk) const { return exists(markerPath("done", chunk)); }
+
+    bool tryLease(const uint64_t& chunk)
+    {
+        if (isDone(chunk)) {
+            return false;
+        }
+        const std::string leasePath = markerPath("lease", chunk);
+        if (createExclusive(leasePath, owner)) {
+            return true;
+        }
+        if (!isExpired(leasePath)) {
+            return false;
+        }
+        // Only one node can move an expired lease aside.
+        const std::string stalePath = leasePath + ".stale." + owner;
+        if (std::rename(leasePath.c_str(), stalePath.c_str())) {
+            return false;
+        }
+        std::remove(stalePath.c_str());
+
+        return createExclusive(leasePath, owner);
+    }
+
+    // Lease the next chunk to search, waiting out other nodes' live leases at the end of the range.
+    // Returns false once every chunk is done, a factor is found, or we're asked to stop.
+    bool acquire(uint64_t& chunk, const std::atomic<bool>& isStopRequested, const double& poll)
+    {
+        while (!isFound() && !isStopRequested.load(std::memory_order_relaxed)) {
+            for (; cursor < chunkCount; ++cursor) {
+                if (tryLease(cursor)) {
+                    chunk = cursor++;
+                    return true;
+                }
+            }
+
+            // End of a pass: pick up the chunks of failed nodes, (or wait on slow ones).
+            bool isPending = false;
+            for (uint64_t c = 0U; c < chunkCount; ++c) {
+                if (isDone(c)) {
+                    continue;
+                }
+                if (tryLease(c)) {
+                    chunk = c;
+                    return true;
+                }
+                isPending = true;
+            }
+            if (!isPending) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(poll));
+        }
+
+        return false;
+    }
+
+    bool renew(const uint64_t& chunk) const
+    {
+        return isOwned(chunk) && !utimensat(AT_FDCWD, markerPath("lease", chunk).c_str(), nullptr, 0);
+    }
+
+    // Give up a chunk, unfinished, so that another node can take it right away.
+    void release(const uint64_t& chunk) const
+    {
+        if (isOwned(chunk)) {
+            std::remove(markerPath("lease", chunk).c_str());
+        }
+    }
+
+    void complete(const uint64_t& chunk) const
+    {
+        createExclusive(markerPath("done", chunk), owner);
+        release(chunk);
+    }
+
+    bool isFound() const { return exists(markerPath("found")); }
+
+    // (Only the first success is kept.)
+    bool markFound(const std::string& result) const { return createExclusive(markerPath("found"), result + "\n"); }
+
+    std::string readFound() const
+    {
+        std::string contents;
+        readAll(markerPath("found"), contents);
+        while (!contents.empty() && (contents.back() == '\n')) {
+            contents.pop_back();
+        }
+
+        return contents;
+    }
+};
+} // namespace Qimcifa
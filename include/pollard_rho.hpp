@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Pollard's rho method, (with Brent's cycle detection,) for a small-to-medium factor of a general
+// integer: iterate y -> y^2 + c (mod N), and a factor "p" shows up as gcd(x - y, N), after about
+// sqrt(p) steps, instead of the p / 3 candidates that trial division costs for it. Rather than one
+// gcd per step, the differences are multiplied together (mod N) in blocks of RHO_GCD_BATCH, with one
+// gcd per block, and a block that overshoots (to N itself) is stepped through again one gcd at a
+// time. Each worker, (on each node,) runs its own independent polynomials, (different "c,") and the
+// first to find a factor stops the rest.
+//
+// Residues are squared at full width, so the search runs at (at least) twice the width of N.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "qimcifa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace Qimcifa {
+
+// Steps per gcd
+constexpr uint64_t RHO_GCD_BATCH = 128U;
+// Seconds of Pollard's rho to try first, by default, when we don't assume a semiprime, (or 0 for none)
+constexpr double DEFAULT_RHO_PREPASS = 10.0;
+
+template <typename BigInteger> struct PollardRho {
+    const BigInteger toFactor;
+    const BigInteger c;
+
+    PollardRho(const BigInteger& n, const BigInteger& cIn)
+        : toFactor(n)
+        , c(cIn)
+    {
+        // Intentionally left blank.
+    }
+
+    inline BigInteger step(const BigInteger& y) const { return (y * y + c) % toFactor; }
+
+    inline static BigInteger difference(const BigInteger& x, const BigInteger& y)
+    {
+        return (x < y) ? (y - x) : (x - y);
+    }
+
+    // A nontrivial factor, or 0, if this polynomial fails, (or the scheduler stops it first)
+    BigInteger find(BatchScheduler& scheduler) const
+    {
+        BigInteger x = 2U, y = 2U, ys = 2U, q = 1U, g = 1U;
+        for (uint64_t r = 1U; g == 1U; r <<= 1U) {
+            x = y;
+            for (uint64_t i = 0U; i < r; ++i) {
+                if (!(i % RHO_GCD_BATCH) && scheduler.isStopped()) {
+                    return 0U;
+                }
+                y = step(y);
+            }
+            for (uint64_t k = 0U; (k < r) && (g == 1U); k += RHO_GCD_BATCH) {
+                if (scheduler.isStopped()) {
+                    return 0U;
+                }
+                ys = y;
+                const uint64_t m = std::min(RHO_GCD_BATCH, r - k);
+                for (uint64_t i = 0U; i < m; ++i) {
+                    y = step(y);
+                    q = (q * difference(x, y)) % toFactor;
+                }
+                g = gcd(q, toFactor);
+            }
+        }
+
+        if (g == toFactor) {
+            // (The last block overshot, so find the first step in it with a factor.)
+            do {
+                ys = step(ys);
+                g = gcd(difference(x, ys), toFactor);
+            } while (g == 1U);
+        }
+
+        return (g == toFactor) ? (BigInteger)0U : g;
+    }
+};
+
+// Run independent polynomials on "workerCount" threads, (distinct across nodes,) until one finds a
+// factor, or "scheduler" stops them, (by its time budget, or an interrupt).
+template <typename BigInteger>
+void runPollardRho(const BigInteger& toFactor, const size_t& nodeCount, const size_t& nodeId,
+    const unsigned& workerCount, BatchScheduler& scheduler)
+{
+    const uint64_t stride = (uint64_t)(nodeCount ? nodeCount : 1U) * (workerCount ? workerCount : 1U);
+    std::vector<std::future<void>> futures;
+    futures.reserve(workerCount);
+    for (unsigned w = 0U; w < workerCount; ++w) {
+        futures.push_back(std::async(std::launch::async, [&toFactor, &scheduler, nodeCount, nodeId, w, stride]() {
+            // (c = 0 and c = -2 are degenerate; we never reach the latter.)
+            for (uint64_t c = 1U + nodeId + nodeCount * w; !scheduler.isStopped(); c += stride) {
+                const BigInteger factor = PollardRho<BigInteger>(toFactor, (BigInteger)c).find(scheduler);
+                if (factor != 0U) {
+                    printSuccess<BigInteger>(factor, toFactor / factor, toFactor, "Pollard rho: Found ", scheduler);
+                    return;
+                }
+            }
+        }));
+    }
+    for (std::future<void>& future : futures) {
+        future.get();
+    }
+}
+} // namespace Qimcifa
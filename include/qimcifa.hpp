@@ -54,9 +54,12 @@
 // See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
 // for details.
 
+#pragma once
+
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <float.h>
@@ -66,16 +69,30 @@
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <stdlib.h>
 #include <string>
 #include <time.h>
 
-#include <boost/dynamic_bitset.hpp>
+#if IS_QUOTIENT_TRACKING
+#include "quotient_tracker.hpp"
+#endif
+#if IS_RANDOM
+#include "batch_permutation.hpp"
+#endif
+#include "batch_sieve.hpp"
+#include "checkpoint.hpp"
+#include "integer_sqrt.hpp"
+#include "search_stats.hpp"
+#include "simd_divisibility.hpp"
+#include "wheel_factorization.hpp"
 
 #if USE_GMP
 #include <boost/multiprecision/gmp.hpp>
 #elif USE_BOOST
 #include <boost/multiprecision/cpp_int.hpp>
+#include "fixed_width_integer.hpp"
 #else
 #include "big_integer.hpp"
 #endif
@@ -96,96 +113,327 @@ typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<819
 typedef BigInteger BigIntegerInput;
 #endif
 
-BigIntegerInput batchNumber;
-BigIntegerInput batchBound;
-BigIntegerInput batchCount;
-std::mutex batchMutex;
+// Batches are handed out in contiguous "claims" of several at once, by atomic fetch-add on a native
+// word counter, so workers never contend on a lock, (or copy multiprecision counters,) per batch.
+// Claims shrink toward the end of the range, (as in "guided self-scheduling,") so that all workers
+// finish at about the same time.
+constexpr uint64_t MAX_BATCH_CLAIM = 64U;
+// (No feasible run comes near 2^63 batches, so we cap the count there, to leave headroom for overshoot.
+// The random order spreads those claims over any wider range, instead, by "super-batches.")
+constexpr uint64_t MAX_BATCH_TOTAL = 1ULL << 63U;
+
+// Workers also check for a stop between batches, every this many candidates, (a power of 2,) so
+// that they all return within milliseconds of a success, interruption, or deadline, even when a
+// single multiprecision batch takes seconds.
+constexpr size_t STOP_CHECK_INTERVAL = 1U << 12U;
 
-inline void finish() {
-    std::lock_guard<std::mutex> lock(batchMutex);
-    batchNumber = batchBound;
+// Process-wide stop request, (e.g., from SIGINT,) that every job observes. A lock-free atomic flag
+// is safe to set from a signal handler.
+inline std::atomic<bool>& getStopRequest()
+{
+    static std::atomic<bool> isStopRequested(false);
+    return isStopRequested;
 }
 
-inline BigIntegerInput getNextBatch() {
-    std::lock_guard<std::mutex> lock(batchMutex);
+inline void requestStop() { getStopRequest().store(true, std::memory_order_relaxed); }
 
-#if IS_SQUARES_CONGRUENCE_CHECK
-    BigIntegerInput result = batchNumber;
+// All the shared state of one factoring job, (or one node's slice of one,) across its workers
+struct BatchScheduler {
+    // Batch number of claim index 0: the highest batch, counting down, (or the lowest, counting up,
+    // for congruence of squares).
+    BigIntegerInput first;
+    uint64_t total;
+    uint64_t workers;
+    std::atomic<uint64_t> claimed;
+    std::atomic<bool> isFinished;
+    std::atomic<bool> isTimedOut;
+    std::atomic<bool> isInterrupted;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start;
+    // (Zero for no time limit)
+    std::chrono::nanoseconds budget;
+    // Batch jobs collect their output, rather than printing it as it happens.
+    bool isQuiet;
+    std::mutex resultMutex;
+    std::string result;
+    // One (nontrivial) factor of the result, for a caller to split the number further, (or 0, for none)
+    BigIntegerInput factor;
+    double resultSeconds;
+    // Completed batch tracking, for checkpoints, (or null, for none)
+    ProgressLedger* ledger;
+    // Throughput counters, (or null, for none)
+    SearchStats* stats;
+    // Primes to sieve each batch with, before dividing, in the semiprime search, (or null, for none)
+    const std::vector<SievePrime>* sievePrimes;
+    // First batch of the (bounded) search interval, across all nodes
+    BigIntegerInput lowBatch;
+#if IS_RANDOM
+    // Seed of the keyed batch order, (with the number itself,) which every node must share
+    uint64_t seed;
+    // Claim index "i" searches super-batch "order.map(orderFirst + i)," (see getRandomBatch()).
+    BatchPermutation order;
+    uint64_t orderFirst;
+    // Batches in the whole interval, and per super-batch, (1, unless there are more than 2^63 batches)
+    BigIntegerInput batchRange;
+    BigIntegerInput superSize;
+    // Random 64-bit words to draw per offset within a super-batch, (enough that the remainder is unbiased)
+    uint32_t superWords;
+    uint64_t superKey;
+#endif
 
-    if (batchNumber < batchBound) {
-        ++batchNumber;
+    BatchScheduler()
+        : first(0U)
+        , total(0U)
+        , workers(1U)
+        , claimed(0U)
+        , isFinished(false)
+        , isTimedOut(false)
+        , isInterrupted(false)
+        , start(std::chrono::high_resolution_clock::now())
+        , budget(0)
+        , isQuiet(false)
+        , factor(0U)
+        , resultSeconds(0.0)
+        , ledger(nullptr)
+        , stats(nullptr)
+        , sievePrimes(nullptr)
+        , lowBatch(0U)
+#if IS_RANDOM
+        , seed(0U)
+        , orderFirst(0U)
+        , batchRange(0U)
+        , superSize(1U)
+        , superWords(0U)
+        , superKey(0U)
+#endif
+    {
+        // Intentionally left blank.
     }
 
-    return result;
-#else
-    BigIntegerInput result = batchCount - (batchNumber + 1U);
+    void setRange(const BigIntegerInput& f, const BigIntegerInput& count, const uint64_t& w)
+    {
+        first = f;
+        total = (count < (BigIntegerInput)MAX_BATCH_TOTAL) ? (uint64_t)count : MAX_BATCH_TOTAL;
+        workers = w ? w : 1U;
+        claimed = 0U;
+        isFinished = false;
+        isTimedOut = false;
+        isInterrupted = false;
+    }
 
-    if (batchNumber == batchBound) {
-        return batchBound;
+    // Track completed batches in a ledger, and only hand out those it still has pending.
+    void attach(ProgressLedger* l)
+    {
+        ledger = l;
+        total = (l->pendingTotal < MAX_BATCH_TOTAL) ? l->pendingTotal : MAX_BATCH_TOTAL;
+        claimed = 0U;
     }
 
-    ++batchNumber;
+#if IS_RANDOM
+    // Order "batchCount" batches from "lowBatch," by the key. Past 2^63 batches, claim indices order
+    // consecutive super-batches of ceil(batchCount / 2^63) batches, instead, and each one searches a
+    // (keyed) pseudo-random batch within its super-batch. Every claim still lands uniformly on the whole
+    // interval, never repeating, (though no run could ever exhaust 2^63 claims).
+    void setOrder(const BigIntegerInput& batchCount, const uint64_t& key)
+    {
+        batchRange = batchCount;
+        superSize = (batchCount + (BigIntegerInput)(MAX_BATCH_TOTAL - 1U)) / (BigIntegerInput)MAX_BATCH_TOTAL;
+        if (superSize == 0U) {
+            superSize = 1U;
+        }
+        uint32_t bits = 0U;
+        for (BigIntegerInput s = superSize; s != 0U; s >>= 1U) {
+            ++bits;
+        }
+        superWords = (bits >> 6U) + 2U;
+        superKey = mix64(key ^ 0xD1B54A32D192ED03ULL);
+        order.setDomain((uint64_t)((batchCount + superSize - 1U) / superSize), key);
+    }
 
-    return result;
+    // The batch number for claim index "i"
+    BigIntegerInput getRandomBatch(const uint64_t& i) const
+    {
+        const uint64_t j = order.map(orderFirst + i);
+        if (superSize == 1U) {
+            return lowBatch + j;
+        }
+        const BigIntegerInput superStart = superSize * (BigIntegerInput)j;
+        const BigIntegerInput remaining = batchRange - superStart;
+        BigIntegerInput offset = 0U;
+        for (uint32_t w = 0U; w < superWords; ++w) {
+            offset = (offset << 64U) | (BigIntegerInput)mix64(superKey + j * superWords + w);
+        }
+
+        return lowBatch + superStart + (offset % ((remaining < superSize) ? remaining : superSize));
+    }
 #endif
-}
 
-// See https://stackoverflow.com/questions/101439/the-most-efficient-way-to-implement-an-integer-based-power-function-powint-int
-template <typename BigInteger> BigInteger ipow(BigInteger base, unsigned exp)
-{
-    BigInteger result = 1U;
-    for (;;)
+    // Narrow a full range of claim indices, (counting from "rangeFirst,") to [start, start + count).
+    void setSlice(const BigIntegerInput& rangeFirst, const uint64_t& start, const uint64_t& count)
     {
-        if (exp & 1U) {
-            result *= base;
+#if IS_RANDOM
+        (void)rangeFirst;
+        orderFirst = start;
+        setRange(0U, (BigIntegerInput)count, workers);
+#elif IS_SQUARES_CONGRUENCE_CHECK
+        setRange(rangeFirst + start, (BigIntegerInput)count, workers);
+#else
+        setRange(rangeFirst - start, (BigIntegerInput)count, workers);
+#endif
+    }
+
+    // (Re)start the job clock, and with it, any time budget.
+    void startClock() { start = std::chrono::high_resolution_clock::now(); }
+
+    double elapsed() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start)
+                   .count() /
+            1000000.0;
+    }
+
+    // Inform the other threads on this job that we're done.
+    void finish() { isFinished = true; }
+
+    bool isExhausted() const { return isFinished.load(std::memory_order_relaxed) || (claimed.load(std::memory_order_relaxed) >= total); }
+
+    // This is the stop token: checked once per batch, and every STOP_CHECK_INTERVAL candidates
+    // within one, which is coarse enough for the clock read not to matter.
+    bool isStopped()
+    {
+        if (isFinished.load(std::memory_order_relaxed)) {
+            return true;
         }
-        exp >>= 1U;
-        if (!exp) {
-            break;
+        if (getStopRequest().load(std::memory_order_relaxed)) {
+            isInterrupted = true;
+            finish();
+            return true;
+        }
+        if (budget.count() && ((std::chrono::high_resolution_clock::now() - start) > budget)) {
+            isTimedOut = true;
+            finish();
+            return true;
         }
-        base *= base;
+
+        return false;
     }
 
-    return result;
-}
+    // Claim the next batch indices, [s, s + count), or return false if there are none left.
+    bool claim(uint64_t& s, uint64_t& count)
+    {
+        const uint64_t seen = claimed.load(std::memory_order_relaxed);
+        if (isFinished.load(std::memory_order_relaxed) || (seen >= total)) {
+            return false;
+        }
 
-template <typename BigInteger> inline uint64_t log2(BigInteger n) {
-#if USE_GMP || USE_BOOST
-    uint64_t pow = 0U;
-    while (n >>= 1U) {
-        ++pow;
+        // (The count is only a hint; another claim might land first, in which case we get a later
+        // slice, or nothing.)
+        count = (total - seen) / (workers << 2U);
+        count = (count < 1U) ? 1U : ((count > MAX_BATCH_CLAIM) ? MAX_BATCH_CLAIM : count);
+        s = claimed.fetch_add(count, std::memory_order_relaxed);
+        if (s >= total) {
+            return false;
+        }
+        if (count > (total - s)) {
+            count = total - s;
+        }
+
+        return true;
     }
-    return pow;
-#else
-    return bi_log2(n);
-#endif
-}
 
-template <typename BigInteger> inline BigInteger sqrt(const BigInteger& toTest)
-{
-    // Otherwise, find b = sqrt(b^2).
-    BigInteger start = 1U, end = toTest >> 1U, ans = 0U;
-    do {
-        const BigInteger mid = (start + end) >> 1U;
-
-        // If toTest is a perfect square
-        const BigInteger sqr = mid * mid;
-        if (sqr == toTest) {
-            return mid;
+    // Keep only the first success, if several workers find one at once.
+    bool setResult(const std::string& r, const BigIntegerInput& f = 0U)
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (!result.empty()) {
+            return false;
         }
+        result = r;
+        factor = f;
+        resultSeconds = elapsed();
+
+        return true;
+    }
+};
 
-        if (sqr < toTest) {
-            // Since we need floor, we update answer when mid*mid is smaller than p, and move closer to sqrt(p).
-            start = mid + 1U;
-            ans = mid;
-        } else {
-            // If mid*mid is greater than p
-            end = mid - 1U;
+// Each worker walks its own claims, and only touches multiprecision batch numbers once per claim.
+// (A worker can also give up after a number of claims, to be rescheduled onto another job.)
+template <typename BigInteger> struct BatchCursor {
+    BatchScheduler& scheduler;
+    uint64_t claimsLeft;
+    uint64_t start;
+    uint64_t index;
+    uint64_t count;
+    BigInteger first;
+    // The (ledger's) batch index of the batch in progress, if there is one
+    uint64_t current;
+    bool isCurrent;
+    WorkerStats* workerStats;
+
+    BatchCursor(BatchScheduler& s, const uint64_t& maxClaims)
+        : scheduler(s)
+        , claimsLeft(maxClaims)
+        , start(0U)
+        , index(0U)
+        , count(0U)
+        , first(0U)
+        , current(0U)
+        , isCurrent(false)
+        , workerStats(s.stats ? &(s.stats->slot()) : nullptr)
+    {
+        // Intentionally left blank.
+    }
+
+    inline bool next(BigInteger& batchNum)
+    {
+        // Asking for the next batch means the last one is done. (A worker that stops partway through
+        // a batch never asks, so that batch stays pending.)
+        if (isCurrent) {
+            if (scheduler.ledger) {
+                scheduler.ledger->complete(current);
+            }
+            if (workerStats) {
+                scheduler.stats->batchDone(*workerStats);
+            }
+            isCurrent = false;
         }
-    } while (start <= end);
 
-    return ans;
-}
+        if (scheduler.isStopped()) {
+            return false;
+        }
+
+        if (index == count) {
+            if (!claimsLeft || !scheduler.claim(start, count)) {
+                return false;
+            }
+            --claimsLeft;
+            index = 0U;
+#if IS_SQUARES_CONGRUENCE_CHECK && !IS_RANDOM
+            first = (BigInteger)(scheduler.first + start);
+#elif !IS_RANDOM
+            first = (BigInteger)(scheduler.first - start);
+#endif
+        }
+
+        uint64_t i = start + index;
+        if (scheduler.ledger) {
+            // Resumed claims can span holes in the completed set, so we map every batch.
+            i = scheduler.ledger->toBatchIndex(i);
+        }
+        current = i;
+        isCurrent = true;
+#if IS_RANDOM
+        // (Consecutive claim indices land on scattered, but never repeated, batches.)
+        batchNum = (BigInteger)scheduler.getRandomBatch(i);
+#elif IS_SQUARES_CONGRUENCE_CHECK
+        batchNum = scheduler.ledger ? (BigInteger)(scheduler.first + i) : (first + index);
+#else
+        batchNum = scheduler.ledger ? (BigInteger)(scheduler.first - i) : (first - index);
+#endif
+        ++index;
+
+        return true;
+    }
+};
 
 template <typename BigInteger> inline bool isPowerOfTwo(const BigInteger& x)
 {
@@ -200,6 +448,89 @@ template <typename BigInteger> inline bool isPowerOfTwo(const BigInteger& x)
 #endif
 }
 
+inline uint32_t getQubitCount(const BigIntegerInput& toFactor)
+{
+    uint32_t qubitCount = 0;
+    BigIntegerInput p = toFactor >> 1U;
+    while (p != 0) {
+        p >>= 1U;
+        ++qubitCount;
+    }
+    if (!isPowerOfTwo(toFactor)) {
+        qubitCount++;
+    }
+
+    return qubitCount;
+}
+
+// The integer width to search a "qubitCount"-bit number at: general integers accumulate products of
+// candidates modulo N, (see GcdAccumulator,) which takes twice the width, (where there's a type for it).
+inline uint32_t getSearchWidth(const uint32_t& qubitCount)
+{
+#if IS_RSA_SEMIPRIME || !(USE_GMP || USE_BOOST)
+    return qubitCount;
+#else
+    return (qubitCount < 4096U) ? (qubitCount << 1U) : qubitCount;
+#endif
+}
+
+// Call "Body<BigInteger>::run()" with the narrowest integer type that holds "qubitCount" bits.
+template <template <typename> class Body, typename... Args>
+int dispatchByWidth(const uint32_t& qubitCount, const BigIntegerInput& toFactor, Args&... args)
+{
+#if !(USE_GMP || USE_BOOST)
+    (void)qubitCount;
+    return Body<BigInteger>::run((BigInteger)toFactor, args...);
+#else
+    if (qubitCount < 64) {
+        typedef uint64_t BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+#if USE_GMP
+    } else {
+        return Body<BigIntegerInput>::run(toFactor, args...);
+    }
+#elif USE_BOOST
+    } else if (qubitCount < 128) {
+        typedef unsigned __int128 BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 192) {
+        typedef uint192_t BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 256) {
+        typedef uint256_t BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 512) {
+        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<512, 512,
+            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
+            BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 1024) {
+        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<1024, 1024,
+            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
+            BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 2048) {
+        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<2048, 2048,
+            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
+            BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 4096) {
+        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<4096, 4096,
+            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
+            BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    } else if (qubitCount < 8192) {
+        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<8192, 8192,
+            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
+            BigInteger;
+        return Body<BigInteger>::run((BigInteger)toFactor, args...);
+    }
+
+    throw std::runtime_error("Number to factor exceeds 8192 templated max bit width!");
+#endif
+#endif
+}
+
 template <typename BigInteger> inline BigInteger gcd(BigInteger n1, BigInteger n2)
 {
     while (n2 != 0) {
@@ -213,13 +544,18 @@ template <typename BigInteger> inline BigInteger gcd(BigInteger n1, BigInteger n
 
 template <typename BigInteger>
 void printSuccess(const BigInteger& f1, const BigInteger& f2, const BigInteger& toFactor, const std::string& message,
-    const std::chrono::time_point<std::chrono::high_resolution_clock>& iterClock)
+    BatchScheduler& scheduler)
 {
-    std::cout << message << f1 << " * " << f2 << " = " << toFactor << std::endl;
-    auto tClock =
-        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - iterClock);
+    scheduler.finish();
+    std::stringstream ss;
+    ss << message << f1 << " * " << f2 << " = " << toFactor;
+    if (!scheduler.setResult(ss.str(), (BigIntegerInput)f1) || scheduler.isQuiet) {
+        return;
+    }
+
+    std::cout << scheduler.result << std::endl;
     // Report in seconds
-    std::cout << "(Time elapsed: " << (tClock.count() / 1000000.0) << " seconds)" << std::endl;
+    std::cout << "(Time elapsed: " << scheduler.resultSeconds << " seconds)" << std::endl;
     std::cout << "(Waiting to join other threads...)" << std::endl;
 }
 
@@ -232,85 +568,175 @@ template <typename BigInteger> inline BigInteger forward(BigInteger p) {
     return (p << 1U) + (~(~p | 1U)) - 1U;
 }
 
-template <typename BigInteger> bool isMultiple(const BigInteger& p, const std::vector<BigInteger>& knownPrimes) {
-    for (const BigInteger& prime : knownPrimes) {
-        if ((p % prime) == 0) {
-            return true;
-        }
+// The interval, [low, high], of the smaller factor between "lowerBound" and "upperBound," (or the
+// square root, if that's lower). Without a lower bound, a semiprime's factors are taken to have equal
+// bit widths, so the smaller is at least 2^(ceil(bits / 2) - 1). (Zero means no bound.) Returns true if
+// "low" comes from that assumption.
+template <typename BigInteger>
+bool getSearchBounds(const BigInteger& toFactor, const BigIntegerInput& lowerBound, const BigIntegerInput& upperBound,
+    BigInteger& low, BigInteger& high)
+{
+    const BigInteger root = isqrt<BigInteger>(toFactor);
+    high = ((upperBound != 0U) && (upperBound < (BigIntegerInput)root)) ? (BigInteger)upperBound : root;
+    low = 1U;
+    if (lowerBound != 0U) {
+        low = (lowerBound < (BigIntegerInput)root) ? (BigInteger)lowerBound : root;
+        return false;
     }
+#if IS_RSA_SEMIPRIME
+    const uint32_t bits = getQubitCount((BigIntegerInput)toFactor);
+    low = ((BigInteger)1U) << (((bits + 1U) >> 1U) - 1U);
+
+    return true;
+#else
     return false;
+#endif
 }
 
+// The batches, [lowBatch, highBatch), (for an offset of 1,) that hold every candidate for the smaller
+// factor in the interval of getSearchBounds().
 template <typename BigInteger>
-boost::dynamic_bitset<size_t> wheel_inc(std::vector<BigInteger> primes, BigInteger limit) {
-    BigInteger radius = 1U;
-    for (const BigInteger& i : primes) {
-        radius *= i;
-    }
-    if (limit < radius) {
-        radius = limit;
-    }
-    const BigInteger prime = primes.back();
-    primes.pop_back();
-    std::vector<bool> o;
-    for (BigInteger i = 1U; i <= radius; ++i) {
-        if (!isMultiple(i, primes)) {
-            o.push_back((i % prime) == 0);
+void getSearchBatches(const BigInteger& toFactor, const BigIntegerInput& lowerBound,
+    const BigIntegerInput& upperBound, BigInteger& lowBatch, BigInteger& highBatch)
+{
+    BigInteger low, high;
+    getSearchBounds(toFactor, lowerBound, upperBound, low, high);
+
+    highBatch = (backward(high) + BIGGEST_WHEEL - 1U) / BIGGEST_WHEEL;
+    // (Batch "k" holds the candidates above backward index k * BIGGEST_WHEEL + 1.)
+    const BigInteger lowIndex = backward(low);
+    lowBatch = (lowIndex < 2U) ? (BigInteger)0U : (BigInteger)((lowIndex - 2U) / BIGGEST_WHEEL);
+    if (lowBatch > highBatch) {
+        lowBatch = highBatch;
+    }
+}
+
+#if IS_SQUARES_CONGRUENCE_CHECK
+// A square is a square modulo anything, so a residue that is not a square modulo 64, 63, 65 or 11 is
+// not a square at all. These four reject all but about 1 in 119 non-squares, from a single remainder
+// by their product, before we take any square root.
+constexpr uint32_t SQUARE_FILTER_MODULI[] = { 64U, 63U, 65U, 11U };
+constexpr uint32_t SQUARE_FILTER_MODULUS = 64U * 63U * 65U * 11U;
+
+struct SquareFilter {
+    // Bit "r" is set if "r" is a square modulo the "i"th modulus, (in 2 words, as one modulus is 65).
+    uint64_t masks[4U][2U];
+
+    SquareFilter()
+    {
+        for (size_t i = 0U; i < 4U; ++i) {
+            const uint32_t& m = SQUARE_FILTER_MODULI[i];
+            masks[i][0U] = 0U;
+            masks[i][1U] = 0U;
+            for (uint32_t x = 0U; x < m; ++x) {
+                const uint32_t r = (x * x) % m;
+                masks[i][r >> 6U] |= 1ULL << (r & 63U);
+            }
         }
     }
 
-    boost::dynamic_bitset<size_t> output(o.size());
-    for (size_t i = 0U; i < o.size(); ++i) {
-        output[i] = o[i];
+    bool isPossibleSquare(const uint32_t& residue) const
+    {
+        for (size_t i = 0U; i < 4U; ++i) {
+            const uint32_t r = residue % SQUARE_FILTER_MODULI[i];
+            if (!((masks[i][r >> 6U] >> (r & 63U)) & 1U)) {
+                return false;
+            }
+        }
+
+        return true;
     }
-    output >>= 1U;
+};
 
-    return output;
+inline const SquareFilter& getSquareFilter()
+{
+    static const SquareFilter filter;
+    return filter;
 }
 
-template <typename BigInteger>
-std::vector<boost::dynamic_bitset<size_t>> wheel_gen(const std::vector<BigInteger>& primes, BigInteger limit) {
-    std::vector<boost::dynamic_bitset<size_t>> output;
-    std::vector<BigInteger> wheelPrimes;
-    for (const BigInteger& p : primes) {
-        wheelPrimes.push_back(p);
-        output.push_back(wheel_inc(wheelPrimes, limit));
-    }
-    return output;
+// (a + b) mod N, for "a" and "b" below N, (where a wrapped sum still leaves the right difference)
+template <typename BigInteger> inline BigInteger addMod(const BigInteger& a, const BigInteger& b, const BigInteger& n)
+{
+    const BigInteger sum = a + b;
+    return ((sum < a) || !(sum < n)) ? (BigInteger)(sum - n) : sum;
 }
 
-inline size_t GetWheelIncrement(std::vector<boost::dynamic_bitset<size_t>>& inc_seqs) {
-    size_t wheelIncrement = 0U;
-    bool is_wheel_multiple = false;
-    do {
-        for (size_t i = 0; i < inc_seqs.size(); ++i) {
-            boost::dynamic_bitset<size_t>& wheel = inc_seqs[i];
-            is_wheel_multiple = wheel.test(0U);
-            wheel >>= 1U;
-            if (is_wheel_multiple) {
-                wheel[wheel.size() - 1U] = true;
-                break;
-            }
+// (a * b) mod N, for "a" below N, by doubling and adding, (so nothing wider than N is ever formed)
+template <typename BigInteger> BigInteger mulMod(const BigInteger& a, const BigInteger& b, const BigInteger& n)
+{
+    BigInteger product = 0U;
+    if (b == 0U) {
+        return product;
+    }
+    for (int64_t i = (int64_t)log2(b); i >= 0; --i) {
+        product = addMod(product, product, n);
+        if (((b >> (uint32_t)i) & 1U) != 0U) {
+            product = addMod(product, a, n);
         }
-        wheelIncrement++;
-    } while (is_wheel_multiple);
+    }
 
-    return wheelIncrement;
+    return product;
 }
 
-#if IS_SQUARES_CONGRUENCE_CHECK
+// Squares of successive candidates, modulo N: from "t" to "t + d," the square grows by d (2t + d), which
+// we form from 2t (mod N) by doubling and adding, in a handful of modular additions, rather than by a
+// full-width multiplication and division, (which could also overflow, for "t" above the square root).
+template <typename BigInteger> struct SquareResidue {
+    const BigInteger toFactor;
+    // The candidate, and its square and double, modulo N
+    BigInteger t;
+    BigInteger square;
+    BigInteger twice;
+    // Parity of the backward index, (for the forward step)
+    bool isOdd;
+
+    SquareResidue(const BigInteger& n)
+        : toFactor(n)
+        , t(0U)
+        , square(0U)
+        , twice(0U)
+        , isOdd(false)
+    {
+        // Intentionally left blank.
+    }
+
+    // Start at forward(p).
+    void reset(const BigInteger& p)
+    {
+        t = forward(p);
+        isOdd = (p & 1U) != 0U;
+        const BigInteger r = t % toFactor;
+        square = mulMod(r, r, toFactor);
+        twice = addMod(r, r, toFactor);
+    }
+
+    // Step the backward index by "g."
+    void advance(const size_t& g)
+    {
+        const bool wasOdd = isOdd;
+        isOdd = isOdd ^ ((g & 1U) != 0U);
+        const uint64_t d = 3U * g + wasOdd - isOdd;
+        const BigInteger dMod = ((BigInteger)d) % toFactor;
+        square = addMod(square, mulMod(addMod(twice, dMod, toFactor), (BigInteger)d, toFactor), toFactor);
+        twice = addMod(twice, addMod(dMod, dMod, toFactor), toFactor);
+        t = t + d;
+    }
+};
+
 template <typename BigInteger>
-inline bool checkCongruenceOfSquares(const BigInteger& toFactor, const BigInteger& toTest,
-    const std::chrono::time_point<std::chrono::high_resolution_clock>& iterClock)
+inline bool checkCongruenceOfSquares(const BigInteger& toFactor, const BigInteger& toTest, const BigInteger& bSqr,
+    BatchScheduler& scheduler)
 {
     // The basic idea is "congruence of squares":
     // a^2 = b^2 mod N
     // If we're lucky enough that the above is true, for a^2 = toTest and (b^2 mod N) = remainder,
     // then we can immediately find a factor.
 
-    // Consider a to be equal to "toTest."
-    const BigInteger bSqr = (toTest * toTest) % toFactor;
-    const BigInteger b = sqrt(bSqr);
+    // Consider a to be equal to "toTest," and (a^2 mod N) to be "bSqr."
+    if (!getSquareFilter().isPossibleSquare((uint32_t)(bSqr % SQUARE_FILTER_MODULUS))) {
+        return false;
+    }
+    const BigInteger b = isqrt(bSqr);
     if ((b * b) != bSqr) {
         return false;
     }
@@ -325,8 +751,7 @@ inline bool checkCongruenceOfSquares(const BigInteger& toFactor, const BigIntege
         fmul = f1 * f2;
     }
     if ((fmul == toFactor) && (f1 > 1U) && (f2 > 1U)) {
-        // Inform the other threads on this node that we've succeeded and are done:
-        printSuccess<BigInteger>(f1, f2, toFactor, "Congruence of squares: Found ", iterClock);
+        printSuccess<BigInteger>(f1, f2, toFactor, "Congruence of squares: Found ", scheduler);
         return true;
     }
 
@@ -334,44 +759,319 @@ inline bool checkCongruenceOfSquares(const BigInteger& toFactor, const BigIntege
 }
 #endif
 
+// Candidates per gcd, when accumulating
+constexpr size_t GCD_BATCH = 128U;
+
+// Pollard's accumulation trick, for general integers: rather than a full Euclidean gcd for every
+// candidate, multiply candidates together, modulo N, and take one gcd per GCD_BATCH of them. Only a
+// block with a common factor is gone back through, one gcd at a time. (This needs the integer type to
+// hold the product of two residues, which is why general integers are searched at twice their width.)
+template <typename BigInteger> struct GcdAccumulator {
+    const BigInteger toFactor;
+    const bool isEnabled;
+    BigInteger product;
+    BigInteger candidates[GCD_BATCH];
+    size_t count;
+
+    GcdAccumulator(const BigInteger& n)
+        : toFactor(n)
+        , isEnabled(((n * n) / n) == n)
+        , product(1U)
+        , count(0U)
+    {
+        // Intentionally left blank.
+    }
+
+    static bool check(const BigInteger& toFactor, const BigInteger& base, BatchScheduler& scheduler)
+    {
+        const BigInteger n = gcd(base, toFactor);
+        if (n != 1U) {
+            printSuccess<BigInteger>(n, toFactor / n, toFactor, "Has common factor: Found ", scheduler);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Take the gcd of the block so far, (and go back through it, if that has a common factor).
+    bool flush(BatchScheduler& scheduler)
+    {
+        const size_t c = count;
+        count = 0U;
+        if (c & 1U) {
+            product = (product * candidates[c - 1U]) % toFactor;
+        }
+        if (!c || (gcd(product, toFactor) == 1U)) {
+            product = 1U;
+            return false;
+        }
+        product = 1U;
+        for (size_t i = 0U; i < c; ++i) {
+            if (check(toFactor, candidates[i], scheduler)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool add(const BigInteger& base, BatchScheduler& scheduler)
+    {
+        if (!isEnabled) {
+            return check(toFactor, base, scheduler);
+        }
+        candidates[count++] = base;
+        // (Candidates are below the square root, (but for squares mode,) so pairs of them multiply to
+        // below N, and take one reduction, instead of two.)
+        if (!(count & 1U)) {
+            BigInteger pair = candidates[count - 2U] * base;
+            if (!(pair < toFactor)) {
+                pair = pair % toFactor;
+            }
+            product = (product * pair) % toFactor;
+        }
+
+        return (count == GCD_BATCH) && flush(scheduler);
+    }
+};
+
 template <typename BigInteger>
 inline bool getSmoothNumbersIteration(const BigInteger& toFactor, const BigInteger& base,
-    const std::chrono::time_point<std::chrono::high_resolution_clock>& iterClock) {
+    BatchScheduler& scheduler, GcdAccumulator<BigInteger>* accumulator = nullptr) {
 #if IS_RSA_SEMIPRIME
+    (void)accumulator;
     if ((toFactor % base) == 0U) {
-        printSuccess<BigInteger>(base, toFactor / base, toFactor, "Exact factor: Found ", iterClock);
+        printSuccess<BigInteger>(base, toFactor / base, toFactor, "Exact factor: Found ", scheduler);
         return true;
     }
 #else
-    BigInteger n = gcd(base, toFactor);
-    if (n != 1U) {
-        printSuccess<BigInteger>(n, toFactor / n, toFactor, "Has common factor: Found ", iterClock);
+    if (accumulator ? accumulator->add(base, scheduler)
+                    : GcdAccumulator<BigInteger>::check(toFactor, base, scheduler)) {
         return true;
     }
 #endif
 
-#if IS_SQUARES_CONGRUENCE_CHECK
-    return checkCongruenceOfSquares<BigInteger>(toFactor, base, iterClock);
-#else
     return false;
-#endif
 }
 
 template <typename BigInteger>
-bool getSmoothNumbers(const BigInteger& toFactor, std::vector<boost::dynamic_bitset<uint64_t>>& inc_seqs, const BigInteger& offset,
-    const std::chrono::time_point<std::chrono::high_resolution_clock>& iterClock)
+bool getSmoothNumbers(const BigInteger& toFactor, WheelIterator& wheel, const BigInteger& offset,
+    BatchScheduler& scheduler, const uint64_t& maxClaims = UINT64_MAX)
 {
-    for (BigInteger batchNum = (BigInteger)getNextBatch(); batchNum < batchBound; batchNum = (BigInteger)getNextBatch()) {
+    BatchCursor<BigInteger> batches(scheduler, maxClaims);
+    WorkerStats* stats = batches.workerStats;
+#if IS_RSA_SEMIPRIME && !IS_SQUARES_CONGRUENCE_CHECK
+    // Every batch starts at an even multiple of the wheel, so the backward index parity, and the
+    // forward step between consecutive candidates, are native-word quantities: we can step each
+    // candidate directly, rather than recomputing "forward(p)" in full width.
+#if IS_QUOTIENT_TRACKING
+    // Candidates ascend within each batch, so we can track the quotient instead of dividing.
+    QuotientTracker<BigInteger> tracker(toFactor);
+#endif
+    const bool isOffsetOdd = (offset & 1U) != 0U;
+    // The factor is prime, so candidates with a small prime factor are sieved out before dividing.
+    BatchSieve sieve(scheduler.sievePrimes, BIGGEST_WHEEL);
+    for (BigInteger batchNum = 0U; batches.next(batchNum);) {
         const BigInteger batchStart = batchNum * BIGGEST_WHEEL + offset;
+        BigInteger base = forward<BigInteger>(batchStart);
+#if IS_QUOTIENT_TRACKING
+        tracker.reset(base);
+#endif
+        bool isOdd = isOffsetOdd;
+        size_t p = 0U;
+        // forward(b + g) - forward(b) = 3g + (b & 1) - ((b + g) & 1), summed up to the next sieve survivor
+        const auto step = [&wheel, &sieve, &isOdd, &p]() -> uint64_t {
+            uint64_t delta = 0U;
+            do {
+                const size_t g = wheel.next();
+                p += g;
+                const bool wasOdd = isOdd;
+                isOdd = isOdd ^ ((g & 1U) != 0U);
+                delta += 3U * g + wasOdd - isOdd;
+            } while (sieve.isComposite(p));
+
+            return delta;
+        };
+        wheel.reset(batchStart);
+        sieve.mark(batchStart);
+        size_t stopCheck = 0U;
+        while (p < (size_t)BIGGEST_WHEEL) {
+            if (!(++stopCheck & (STOP_CHECK_INTERVAL - 1U))) {
+                if (scheduler.isStopped()) {
+                    return false;
+                }
+#if !IS_QUOTIENT_TRACKING
+                if (stats) {
+                    // Time a short block of steps, then its divisions, separately.
+                    BigInteger sample[STATS_SAMPLE_LENGTH];
+                    size_t count = 0U;
+                    const auto stepStart = StatsClock::now();
+                    while ((count < STATS_SAMPLE_LENGTH) && (p < (size_t)BIGGEST_WHEEL)) {
+                        base = base + step();
+                        sample[count++] = base;
+                    }
+                    const auto divideStart = StatsClock::now();
+                    for (size_t i = 0U; i < count; ++i) {
+                        if (getSmoothNumbersIteration<BigInteger>(toFactor, sample[i], scheduler)) {
+                            return true;
+                        }
+                    }
+                    stats->addSample(count, divideStart - stepStart, StatsClock::now() - divideStart);
+                    stopCheck += count - 1U;
+                    continue;
+                }
+#endif
+            }
+#if IS_QUOTIENT_TRACKING
+            if ((tracker.advance(step()) == 0U) &&
+                getSmoothNumbersIteration<BigInteger>(toFactor, tracker.d, scheduler)) {
+                return true;
+            }
+#else
+            base = base + step();
+            if (getSmoothNumbersIteration<BigInteger>(toFactor, base, scheduler)) {
+                return true;
+            }
+#endif
+        }
+        if (stats) {
+            stats->addCandidates(stopCheck);
+        }
+    }
+#else
+    GcdAccumulator<BigInteger> accumulator(toFactor);
+#if IS_SQUARES_CONGRUENCE_CHECK
+    SquareResidue<BigInteger> squares(toFactor);
+    // Step the square along with the candidate, then test it.
+    const auto checkSquare = [&toFactor, &squares, &scheduler](const size_t& g) {
+        squares.advance(g);
+        return checkCongruenceOfSquares<BigInteger>(toFactor, squares.t, squares.square, scheduler);
+    };
+#endif
+    for (BigInteger batchNum = 0U; batches.next(batchNum);) {
+        BigInteger p = batchNum * BIGGEST_WHEEL + offset;
         const BigInteger batchEnd = (batchNum + 1U) * BIGGEST_WHEEL + offset;
-        for (BigInteger p = batchStart; p < batchEnd;) {
-            p += GetWheelIncrement(inc_seqs);
-            if (getSmoothNumbersIteration<BigInteger>(toFactor, forward(p), iterClock)) {
+        wheel.reset(p);
+#if IS_SQUARES_CONGRUENCE_CHECK
+        squares.reset(p);
+#endif
+        size_t stopCheck = 0U;
+        while (p < batchEnd) {
+            if (!(++stopCheck & (STOP_CHECK_INTERVAL - 1U))) {
+                if (scheduler.isStopped()) {
+                    return accumulator.flush(scheduler);
+                }
+                if (stats) {
+                    // Time a short block of steps, then its divisions, separately.
+                    BigInteger sample[STATS_SAMPLE_LENGTH];
+#if IS_SQUARES_CONGRUENCE_CHECK
+                    size_t gaps[STATS_SAMPLE_LENGTH];
+#endif
+                    size_t count = 0U;
+                    const auto stepStart = StatsClock::now();
+                    while ((count < STATS_SAMPLE_LENGTH) && (p < batchEnd)) {
+                        const size_t g = wheel.next();
+                        p += g;
+#if IS_SQUARES_CONGRUENCE_CHECK
+                        gaps[count] = g;
+#endif
+                        sample[count++] = forward(p);
+                    }
+                    const auto divideStart = StatsClock::now();
+                    for (size_t i = 0U; i < count; ++i) {
+                        if (getSmoothNumbersIteration<BigInteger>(toFactor, sample[i], scheduler, &accumulator)) {
+                            return true;
+                        }
+#if IS_SQUARES_CONGRUENCE_CHECK
+                        if (checkSquare(gaps[i])) {
+                            return true;
+                        }
+#endif
+                    }
+                    stats->addSample(count, divideStart - stepStart, StatsClock::now() - divideStart);
+                    stopCheck += count - 1U;
+                    continue;
+                }
+            }
+            const size_t g = wheel.next();
+            p += g;
+            if (getSmoothNumbersIteration<BigInteger>(toFactor, forward(p), scheduler, &accumulator)) {
+                return true;
+            }
+#if IS_SQUARES_CONGRUENCE_CHECK
+            if (checkSquare(g)) {
                 return true;
             }
+#endif
+        }
+        // (A batch only counts as done once all its candidates are checked.)
+        if (accumulator.flush(scheduler)) {
+            return true;
+        }
+        if (stats) {
+            stats->addCandidates(stopCheck);
+        }
+    }
+#endif
+
+    return false;
+}
+
+#if IS_RSA_SEMIPRIME && !IS_SQUARES_CONGRUENCE_CHECK
+// On the native word rung, we test a whole block of wheel candidates per (vectorized) kernel call.
+template <>
+inline bool getSmoothNumbers<uint64_t>(const uint64_t& toFactor, WheelIterator& wheel, const uint64_t& offset,
+    BatchScheduler& scheduler, const uint64_t& maxClaims)
+{
+    const DivisibilityKernel isDivisible = getDivisibilityKernel();
+    BatchCursor<uint64_t> batches(scheduler, maxClaims);
+    WorkerStats* stats = batches.workerStats;
+    // (The vectorized divisibility test costs less per candidate than sieving, so we don't sieve here.)
+    uint64_t block[DIVISIBILITY_BLOCK];
+    for (uint64_t batchNum = 0U; batches.next(batchNum);) {
+        const uint64_t batchStart = batchNum * BIGGEST_WHEEL + offset;
+        const uint64_t batchEnd = (batchNum + 1U) * BIGGEST_WHEEL + offset;
+        wheel.reset(batchStart);
+        uint64_t p = batchStart;
+        size_t stopCheck = 0U;
+        uint64_t tested = 0U;
+        while (p < batchEnd) {
+            bool isSampled = false;
+            if (!(++stopCheck & ((STOP_CHECK_INTERVAL / DIVISIBILITY_BLOCK) - 1U))) {
+                if (scheduler.isStopped()) {
+                    return false;
+                }
+                isSampled = stats != nullptr;
+            }
+            const auto stepStart = isSampled ? StatsClock::now() : StatsClock::time_point();
+            size_t count = 0U;
+            while ((count < DIVISIBILITY_BLOCK) && (p < batchEnd)) {
+                p += wheel.next();
+                block[count++] = forward(p);
+            }
+            tested += count;
+            if (count < DIVISIBILITY_BLOCK) {
+                // Pad the batch tail with an odd divisor that can never divide toFactor.
+                std::fill(block + count, block + DIVISIBILITY_BLOCK, (toFactor | 1U) + 2U);
+            }
+            const auto divideStart = isSampled ? StatsClock::now() : StatsClock::time_point();
+            const uint32_t hits = isDivisible(toFactor, block);
+            // Confirm (and report) hits in ascending order, exactly as the scalar loop would have.
+            for (size_t i = 0U; (hits >> i) != 0U; ++i) {
+                if (((hits >> i) & 1U) && getSmoothNumbersIteration<uint64_t>(toFactor, block[i], scheduler)) {
+                    return true;
+                }
+            }
+            if (isSampled) {
+                stats->addSample(count, divideStart - stepStart, StatsClock::now() - divideStart);
+            }
+        }
+        if (stats) {
+            stats->addCandidates(tested);
         }
     }
 
     return false;
 }
+#endif
 } // namespace Qimcifa
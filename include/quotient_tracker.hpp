@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Incremental exact-divisibility tracking, for the sequential (ascending) wheel sweep.
+//
+// The number to factor, "n," is fixed for the whole search, and the candidate divisor only moves
+// up by a few units at a time. If "n = q * d + r," then for "d' = d + delta," we have
+// "n = q * d' + (r - q * delta)." So, the new remainder costs one product with a small factor and
+// one subtraction, and the quotient only needs correcting (downward) when "q * delta" exceeds "r."
+// The size of that correction, (roughly "q * delta / d'," only a few units near the square root of
+// "n,") is estimated in floating-point and then fixed up exactly, so each step costs a handful of
+// limb-by-word products and additions, instead of a full multi-limb division.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "config.h"
+
+#include <cstdint>
+
+#if !USE_BOOST && !USE_GMP
+#include "big_integer.hpp"
+#endif
+
+namespace Qimcifa {
+
+// Corrections beyond this many units fall back to a full division.
+constexpr uint64_t MAX_QUOTIENT_STEP = 1ULL << 32U;
+
+// (The pure language "BigInteger" has no cast to double.)
+template <typename BigInteger> inline double quotientToDouble(const BigInteger& n) { return (double)n; }
+#if !USE_BOOST && !USE_GMP
+inline double quotientToDouble(const BigInteger& n) { return bi_to_double(n); }
+#endif
+
+// (Only plain binary operators are used, since not every big integer back end supports compound
+// assignment with value semantics.)
+template <typename BigInteger> struct QuotientTracker {
+    const BigInteger n;
+    BigInteger d;
+    BigInteger q;
+    BigInteger r;
+    // Floating-point estimate of "q / d," refreshed on every full division
+    double ratio;
+
+    QuotientTracker(const BigInteger& toFactor)
+        : n(toFactor)
+        , d(0U)
+        , q(0U)
+        , r(0U)
+        , ratio(0.0)
+    {
+        // Intentionally left blank.
+    }
+
+    // Full division, to start (or restart) tracking from an arbitrary divisor
+    inline void reset(const BigInteger& divisor)
+    {
+        d = divisor;
+        q = n / d;
+        r = n - q * d;
+        ratio = quotientToDouble(q) / quotientToDouble(d);
+    }
+
+    // Move the divisor up by "delta," and return the remainder of "n" modulo the new divisor.
+    inline const BigInteger& advance(const uint64_t& delta)
+    {
+        if ((delta > MAX_QUOTIENT_STEP) || (d < delta)) {
+            // "q * delta" could exceed "n," (and overflow a fixed width,) so just divide.
+            reset(d + delta);
+            return r;
+        }
+
+        // n = q * d + r = (q - k) * (d + delta) + r', so r' = r + k * (d + delta) - q * delta,
+        // where k is (about) q * delta / (d + delta), give or take 1. (The ratio "q / d" drifts
+        // slowly as "d" grows, and a full division refreshes it whenever the estimate falls behind.)
+        const double kf = ratio * (double)delta;
+        d = d + delta;
+        if (kf >= (double)MAX_QUOTIENT_STEP) {
+            reset(d);
+            return r;
+        }
+        // (Shading the estimate down a little makes it almost always exact or 1 short, so the second
+        // correction loop below practically never runs.)
+        uint64_t k = (uint64_t)(kf * (1.0 - 1e-9));
+
+        const BigInteger t = q * delta;
+        BigInteger a = r + d * k;
+        // The estimate is good to within a unit or two, but we can only check that in exact arithmetic.
+        int corrections = 0;
+        while (a < t) {
+            a = a + d;
+            ++k;
+            if (++corrections > 2) {
+                reset(d);
+                return r;
+            }
+        }
+        while (!((a - t) < d)) {
+            a = a - d;
+            --k;
+            if (++corrections > 2) {
+                reset(d);
+                return r;
+            }
+        }
+
+        q = q - k;
+        r = a - t;
+
+        return r;
+    }
+};
+} // namespace Qimcifa
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Live search statistics: per-worker throughput counters, a periodic summary with an ETA, and a
+// machine-readable stats file, (in the Prometheus text format, e.g., for a "textfile" collector).
+//
+// Each worker owns one cache-line-aligned slot of counters, which only it writes, once per batch,
+// so counting costs no atomic read-modify-write and no cache line contention. The split of time
+// between candidate stepping and division is sampled: every STOP_CHECK_INTERVAL candidates, a
+// worker times a short block of steps, then the divisions for that block, separately.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace Qimcifa {
+
+// Candidates per timed sample, (at most one sample per stop check interval)
+constexpr size_t STATS_SAMPLE_LENGTH = 16U;
+constexpr double DEFAULT_STATS_INTERVAL = 10.0;
+
+typedef std::chrono::steady_clock StatsClock;
+
+struct alignas(64) WorkerStats {
+    std::atomic<uint64_t> candidates;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> sampledCandidates;
+    std::atomic<uint64_t> sampledStepNs;
+    std::atomic<uint64_t> sampledDivideNs;
+    // Time (since the stats started) of the last finished batch
+    std::atomic<int64_t> lastBatchNs;
+
+    WorkerStats()
+        : candidates(0U)
+        , batches(0U)
+        , sampledCandidates(0U)
+        , sampledStepNs(0U)
+        , sampledDivideNs(0U)
+        , lastBatchNs(0)
+    {
+        // Intentionally left blank.
+    }
+
+    // (Only the owning worker writes its slot, so a relaxed load and store suffice.)
+    inline static void add(std::atomic<uint64_t>& counter, const uint64_t& value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    inline void addCandidates(const uint64_t& count) { add(candidates, count); }
+
+    inline void addSample(const uint64_t& count, const StatsClock::duration& step, const StatsClock::duration& divide)
+    {
+        add(sampledCandidates, count);
+        add(sampledStepNs, std::chrono::duration_cast<std::chrono::nanoseconds>(step).count());
+        add(sampledDivideNs, std::chrono::duration_cast<std::chrono::nanoseconds>(divide).count());
+    }
+};
+
+struct SearchStats {
+    const size_t workerCount;
+    std::unique_ptr<WorkerStats[]> workers;
+    // Slots are handed out round-robin, to each new batch cursor.
+    std::atomic<size_t> nextSlot;
+    // Batches in this node's whole range, (for progress and the ETA)
+    uint64_t rangeTotal;
+    // Batches already done before this run, (e.g., from a checkpoint)
+    uint64_t priorBatches;
+    StatsClock::time_point start;
+
+    SearchStats(const size_t& w, const uint64_t& total, const uint64_t& prior)
+        : workerCount(w ? w : 1U)
+        , workers(new WorkerStats[w ? w : 1U])
+        , nextSlot(0U)
+        , rangeTotal(total)
+        , priorBatches(prior)
+        , start(StatsClock::now())
+    {
+        // Intentionally left blank.
+    }
+
+    WorkerStats& slot() { return workers[nextSlot.fetch_add(1U, std::memory_order_relaxed) % workerCount]; }
+
+    inline void batchDone(WorkerStats& worker)
+    {
+        WorkerStats::add(worker.batches, 1U);
+        worker.lastBatchNs.store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count(),
+            std::memory_order_relaxed);
+    }
+
+    struct Totals {
+        double seconds;
+        uint64_t candidates;
+        uint64_t batches;
+        // (Negative, if nothing was sampled)
+        double stepFraction;
+        // Longest time since any worker finished a batch
+        double maxIdle;
+        size_t maxIdleWorker;
+        double eta;
+    };
+
+    Totals totals() const
+    {
+        Totals t{};
+        const int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count();
+        t.seconds = nowNs * 1e-9;
+        uint64_t stepNs = 0U, divideNs = 0U;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            const WorkerStats& w = workers[i];
+            t.candidates += w.candidates.load(std::memory_order_relaxed);
+            t.batches += w.batches.load(std::memory_order_relaxed);
+            stepNs += w.sampledStepNs.load(std::memory_order_relaxed);
+            divideNs += w.sampledDivideNs.load(std::memory_order_relaxed);
+            const double idle = (nowNs - w.lastBatchNs.load(std::memory_order_relaxed)) * 1e-9;
+            if (idle > t.maxIdle) {
+                t.maxIdle = idle;
+                t.maxIdleWorker = i;
+            }
+        }
+        t.stepFraction = (stepNs + divideNs) ? ((double)stepNs / (stepNs + divideNs)) : -1.0;
+        const uint64_t done = priorBatches + t.batches;
+        t.eta = (t.batches && (rangeTotal > done)) ? (t.seconds * (rangeTotal - done) / t.batches) : 0.0;
+
+        return t;
+    }
+
+    // One human-readable progress line
+    std::string summary() const
+    {
+        const Totals t = totals();
+        const uint64_t done = priorBatches + t.batches;
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) << "[stats] " << t.seconds << "s: " << done << "/" << rangeTotal
+           << " batches (" << (rangeTotal ? (100.0 * done / rangeTotal) : 0.0) << "%), "
+           << (t.seconds > 0.0 ? (t.candidates / t.seconds * 1e-6) : 0.0) << "M candidates/s, step/divide ";
+        if (t.stepFraction < 0.0) {
+            ss << "n/a";
+        } else {
+            ss << (100.0 * t.stepFraction) << "%/" << (100.0 * (1.0 - t.stepFraction)) << "%";
+        }
+        ss << ", ETA " << t.eta << "s, longest since a batch: " << t.maxIdle << "s (worker " << t.maxIdleWorker << ")";
+
+        return ss.str();
+    }
+
+    // Write the stats file, atomically replacing the last one, so a scraper never reads half of it.
+    bool writeFile(const std::string& path) const
+    {
+        const Totals t = totals();
+        std::stringstream ss;
+        ss << "# TYPE qimcifa_elapsed_seconds gauge" << std::endl;
+        ss << "qimcifa_elapsed_seconds " << t.seconds << std::endl;
+        ss << "# TYPE qimcifa_batches_range gauge" << std::endl;
+        ss << "qimcifa_batches_range " << rangeTotal << std::endl;
+        ss << "# TYPE qimcifa_batches_prior gauge" << std::endl;
+        ss << "qimcifa_batches_prior " << priorBatches << std::endl;
+        ss << "# TYPE qimcifa_eta_seconds gauge" << std::endl;
+        ss << "qimcifa_eta_seconds " << t.eta << std::endl;
+        ss << "# TYPE qimcifa_candidates_total counter" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_candidates_total{worker=\"" << i << "\"} " << workers[i].candidates << std::endl;
+        }
+        ss << "# TYPE qimcifa_batches_total counter" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_batches_total{worker=\"" << i << "\"} " << workers[i].batches << std::endl;
+        }
+        ss << "# TYPE qimcifa_sampled_candidates_total counter" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_sampled_candidates_total{worker=\"" << i << "\"} " << workers[i].sampledCandidates
+               << std::endl;
+        }
+        ss << "# TYPE qimcifa_sampled_step_seconds_total counter" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_sampled_step_seconds_total{worker=\"" << i << "\"} " << (workers[i].sampledStepNs * 1e-9)
+               << std::endl;
+        }
+        ss << "# TYPE qimcifa_sampled_divide_seconds_total counter" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_sampled_divide_seconds_total{worker=\"" << i << "\"} "
+               << (workers[i].sampledDivideNs * 1e-9) << std::endl;
+        }
+        ss << "# TYPE qimcifa_last_batch_seconds gauge" << std::endl;
+        for (size_t i = 0U; i < workerCount; ++i) {
+            ss << "qimcifa_last_batch_seconds{worker=\"" << i << "\"} " << (workers[i].lastBatchNs * 1e-9)
+               << std::endl;
+        }
+        const std::string contents = ss.str();
+
+        const std::string tmpPath = path + ".tmp";
+        std::FILE* file = std::fopen(tmpPath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        const bool isWritten = std::fwrite(contents.data(), 1U, contents.size(), file) == contents.size();
+        if (std::fclose(file) || !isWritten || std::rename(tmpPath.c_str(), path.c_str())) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+};
+} // namespace Qimcifa
@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Batched exact-divisibility kernels, for the 64-bit (native word) rung of the bit width ladder.
+//
+// A hardware 64-bit divide costs tens of cycles, and we only need to know whether the remainder is
+// zero. For odd "d," let "inv" be the inverse of "d" modulo 2^64, (found by Newton's iteration,
+// with multiplications only). Then "q = n * inv (mod 2^64)" satisfies "q * d = n (mod 2^64)," and
+// "d" exactly divides "n" if and only if the full product "q * d" does not overflow 64 bits,
+// (i.e., the high word of "q * d" is 0). That is a handful of multiplications per candidate, which
+// vectorize 4-wide with AVX2. (Every wheel candidate is odd.) With AVX-512DQ, a floating-point
+// reciprocal estimate of the quotient, corrected in exact integer arithmetic, is cheaper still.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <float.h>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace Qimcifa {
+
+// Candidates tested per kernel call
+constexpr size_t DIVISIBILITY_BLOCK = 16U;
+
+// Sets bit "i" of the result if and only if "d[i]" exactly divides "n."
+typedef uint32_t (*DivisibilityKernel)(const uint64_t& n, const uint64_t* d);
+
+inline uint32_t divisibleScalar(const uint64_t& n, const uint64_t* d)
+{
+    uint32_t mask = 0U;
+    for (size_t i = 0U; i < DIVISIBILITY_BLOCK; ++i) {
+        if ((n % d[i]) == 0U) {
+            mask |= 1U << i;
+        }
+    }
+
+    return mask;
+}
+
+#if defined(__x86_64__)
+// Low 64 bits of the lane-wise 64x64 product, from 32x32->64 products
+__attribute__((target("avx2"))) inline __m256i mulLo64Avx2(const __m256i& a, const __m256i& b)
+{
+    const __m256i lo = _mm256_mul_epu32(a, b);
+    const __m256i c1 = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    const __m256i c2 = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(_mm256_add_epi64(c1, c2), 32));
+}
+
+// Lane-wise test for a 0 high word in the full 64x64->128 product
+__attribute__((target("avx2"))) inline __m256i isMulHiZeroAvx2(const __m256i& a, const __m256i& b)
+{
+    const __m256i mask32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i ah = _mm256_srli_epi64(a, 32);
+    const __m256i bh = _mm256_srli_epi64(b, 32);
+    const __m256i p00 = _mm256_mul_epu32(a, b);
+    const __m256i p01 = _mm256_mul_epu32(a, bh);
+    const __m256i p10 = _mm256_mul_epu32(ah, b);
+    const __m256i p11 = _mm256_mul_epu32(ah, bh);
+    const __m256i mid = _mm256_add_epi64(_mm256_srli_epi64(p00, 32),
+        _mm256_add_epi64(_mm256_and_si256(p01, mask32), _mm256_and_si256(p10, mask32)));
+    const __m256i hi = _mm256_add_epi64(_mm256_add_epi64(p11, _mm256_srli_epi64(mid, 32)),
+        _mm256_add_epi64(_mm256_srli_epi64(p01, 32), _mm256_srli_epi64(p10, 32)));
+
+    return _mm256_cmpeq_epi64(hi, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) inline uint32_t divisibleAvx2(const uint64_t& n, const uint64_t* d)
+{
+    constexpr size_t VECTORS = DIVISIBILITY_BLOCK >> 2U;
+    const __m256i vn = _mm256_set1_epi64x((long long)n);
+    const __m256i two = _mm256_set1_epi64x(2LL);
+
+    // The Newton iteration is a long dependency chain, so we interleave all lanes of the block.
+    __m256i vd[VECTORS], inv[VECTORS];
+    for (size_t i = 0U; i < VECTORS; ++i) {
+        vd[i] = _mm256_loadu_si256((const __m256i*)(d + (i << 2U)));
+        // (3 * d) XOR 2 is the inverse of (odd) d to 5 bits; each Newton step doubles that.
+        inv[i] = _mm256_xor_si256(_mm256_add_epi64(vd[i], _mm256_add_epi64(vd[i], vd[i])), two);
+    }
+    for (int j = 0; j < 4; ++j) {
+        for (size_t i = 0U; i < VECTORS; ++i) {
+            inv[i] = mulLo64Avx2(inv[i], _mm256_sub_epi64(two, mulLo64Avx2(vd[i], inv[i])));
+        }
+    }
+
+    uint32_t mask = 0U;
+    for (size_t i = 0U; i < VECTORS; ++i) {
+        const __m256i q = mulLo64Avx2(vn, inv[i]);
+        mask |= (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(isMulHiZeroAvx2(q, vd[i]))) << (i << 2U);
+    }
+
+    return mask;
+}
+
+// (GCC's own AVX-512 headers trip "-Wuninitialized" on their "undefined" pass-through registers.)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// With AVX-512DQ, we have native 64-bit conversions and products, so we can estimate the quotient
+// with a floating-point reciprocal instead, and correct it exactly in integer arithmetic.
+// (This requires n < 2^63, which the bit width ladder guarantees for the 64-bit rung.)
+__attribute__((target("avx512f,avx512dq"))) inline uint32_t divisibleAvx512(const uint64_t& n, const uint64_t* d)
+{
+    constexpr size_t VECTORS = DIVISIBILITY_BLOCK >> 3U;
+    const __m512i vn = _mm512_set1_epi64((long long)n);
+    const __m512d dn = _mm512_set1_pd((double)n);
+    const __m512d one = _mm512_set1_pd(1.0);
+
+    uint32_t mask = 0U;
+    for (size_t i = 0U; i < VECTORS; ++i) {
+        const __m512i vd = _mm512_loadu_si512((const void*)(d + (i << 3U)));
+        const __m512d dd = _mm512_cvtepu64_pd(vd);
+        // 14-bit reciprocal estimate, refined twice to full double precision
+        __m512d rcp = _mm512_rcp14_pd(dd);
+        rcp = _mm512_fmadd_pd(rcp, _mm512_fnmadd_pd(dd, rcp, one), rcp);
+        rcp = _mm512_fmadd_pd(rcp, _mm512_fnmadd_pd(dd, rcp, one), rcp);
+
+        // First estimate is within a few thousand of the quotient; the remainder is then exact, (as signed).
+        const __m512i q1 = _mm512_cvttpd_epu64(_mm512_mul_pd(dn, rcp));
+        const __m512i r1 = _mm512_sub_epi64(vn, _mm512_mullo_epi64(q1, vd));
+        // Second estimate, rounded to nearest, leaves a remainder of 0 if and only if d divides n.
+        const __m512i q2 = _mm512_cvtpd_epi64(_mm512_mul_pd(_mm512_cvtepi64_pd(r1), rcp));
+        const __m512i r2 = _mm512_sub_epi64(r1, _mm512_mullo_epi64(q2, vd));
+
+        mask |= (uint32_t)_mm512_cmpeq_epi64_mask(r2, _mm512_setzero_si512()) << (i << 3U);
+    }
+
+    return mask;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// Average time per kernel call, over a fixed sample of (odd) candidates
+inline double timeDivisibilityKernel(const DivisibilityKernel& kernel)
+{
+    constexpr size_t SAMPLE_BLOCKS = 1024U;
+    constexpr uint64_t n = 0x7FFFFFFFFFFFFFE7ULL;
+    uint64_t d[DIVISIBILITY_BLOCK];
+    uint32_t hits = 0U;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0U; b < SAMPLE_BLOCKS; ++b) {
+        for (size_t i = 0U; i < DIVISIBILITY_BLOCK; ++i) {
+            d[i] = ((b * DIVISIBILITY_BLOCK + i) << 17U) | 1U;
+        }
+        hits |= kernel(n, d);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    // (Keep the result live, so the calls can't be elided.)
+    volatile uint32_t sink = hits;
+    (void)sink;
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Choose the fastest kernel this CPU supports, once per process. Whether the vector kernels beat
+// the hardware divider depends heavily on the microarchitecture, so we time each one, briefly.
+inline DivisibilityKernel getDivisibilityKernel()
+{
+    static const DivisibilityKernel kernel = []() -> DivisibilityKernel {
+        std::vector<DivisibilityKernel> kernels{ divisibleScalar };
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.push_back(divisibleAvx2);
+        }
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+            kernels.push_back(divisibleAvx512);
+        }
+#endif
+        DivisibilityKernel best = divisibleScalar;
+        double bestTime = DBL_MAX;
+        for (const DivisibilityKernel& k : kernels) {
+            // (Warm up once, then keep the better of two timings.)
+            timeDivisibilityKernel(k);
+            const double t = std::min(timeDivisibilityKernel(k), timeDivisibilityKernel(k));
+            if (t < bestTime) {
+                bestTime = t;
+                best = k;
+            }
+        }
+
+        return best;
+    }();
+
+    return kernel;
+}
+} // namespace Qimcifa
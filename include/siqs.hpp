@@ -0,0 +1,764 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// The self-initialising quadratic sieve, (SIQS,) relation collection: where the exhaustive search
+// costs about sqrt(N) divisions, this finds many "smooth" values Q = (Ax + B)^2 - kN, (which factor
+// entirely over a base of small primes,) in time sub-exponential in the size of N. Each Q is
+// divisible by A, so we sieve over g(x) = Q / A instead, for "x" in [-M, M).
+//
+// - The multiplier "k" is chosen by the Knuth-Schroeppel function, so kN is a quadratic residue
+//   of as many small primes as possible. The factor base is the primes (from the prime sieve,) for
+//   which kN is a residue, with one square root of kN for each.
+// - Each "A" is a product of a few factor base primes, chosen so A is close to sqrt(2kN) / M, which
+//   keeps |g(x)| near M sqrt(kN / 2) over the interval. Each "A" has 2^(s - 1) valid "B," and each
+//   next "B" (in Gray code order) changes the sieve roots of every prime by one precomputed addition
+//   modulo the prime, so switching polynomials costs almost nothing. That is the "self-initialising."
+// - Sieving adds an approximate base-2 logarithm of each prime at each of its roots, over blocks of
+//   SIQS_BLOCK bytes, (which stay in the L1 cache,) and only positions that reach a threshold are
+//   trial divided. The smallest primes are never sieved, only trial divided.
+// - A value that leaves a single cofactor below the large prime bound, (after the factor base,) is
+//   kept as a partial relation, and two partials with the same large prime combine into one
+//   relation. This single large prime variation roughly doubles the yield, near the end.
+// - Every worker sieves its own "A," (and all its "B,") and all share one relation store.
+//
+// A relation is an "y" with y^2 equal to the product of its factor base primes, (and the square of
+// its large prime, if any,) modulo N. Linear algebra over GF(2) finds sets of relations whose
+// products are squares, x^2 = y^2 (mod N,) and each such set splits N by gcd(x - y, N) with
+// probability at least 1/2. If none does, we collect SIQS_EXTRA_RELATIONS more, and try again.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include "batch_sieve.hpp"
+#include "gf2_matrix.hpp"
+#include "qimcifa.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace Qimcifa {
+
+// Bytes per sieve block, (to stay in the L1 cache)
+constexpr size_t SIQS_BLOCK = 1U << 15U;
+// Primes below this are trial divided, but never sieved.
+constexpr uint32_t SIQS_MIN_SIEVE_PRIME = 32U;
+// Bits below the expected size of a smooth g(x) to sieve for
+constexpr double SIQS_THRESHOLD_MARGIN = 8.0;
+// Relations to collect beyond the factor base size, (for enough independent dependencies)
+constexpr size_t SIQS_EXTRA_RELATIONS = 96U;
+// Dependencies to try, per round of linear algebra
+constexpr size_t SIQS_DEPENDENCIES = 64U;
+// Rounds of linear algebra before giving up, (as N is then almost surely a prime, or a prime power)
+constexpr size_t SIQS_MAX_ROUNDS = 8U;
+// Narrower inputs are left to the other engines.
+constexpr uint32_t SIQS_MIN_BITS = 64U;
+// Odd, square-free multiplier candidates
+constexpr uint32_t SIQS_MULTIPLIERS[] = { 1U, 3U, 5U, 7U, 11U, 13U, 15U, 17U, 19U, 21U, 23U, 29U, 31U, 33U, 35U,
+    37U, 39U, 41U, 43U, 47U, 51U, 53U, 55U, 57U, 59U, 61U, 65U, 67U, 69U, 71U, 73U };
+
+struct SiqsParameters {
+    uint32_t bits;
+    uint32_t factorBaseSize;
+    // Half the sieve interval, "M"
+    uint32_t halfInterval;
+    // The large prime bound is this times the largest factor base prime.
+    uint32_t largePrimeMultiplier;
+};
+
+// By the bit width of kN, (interpolated between rows)
+constexpr SiqsParameters SIQS_PARAMETERS[] = { { 64U, 150U, 16384U, 30U }, { 128U, 700U, 16384U, 40U },
+    { 160U, 1500U, 16384U, 50U }, { 200U, 3600U, 32768U, 60U }, { 233U, 6500U, 32768U, 70U },
+    { 266U, 12000U, 49152U, 80U }, { 300U, 22000U, 65536U, 90U }, { 333U, 36000U, 98304U, 100U },
+    { 366U, 50000U, 131072U, 120U }, { 400U, 64000U, 163840U, 128U } };
+
+inline SiqsParameters getSiqsParameters(const uint32_t& bits)
+{
+    constexpr size_t rows = sizeof(SIQS_PARAMETERS) / sizeof(SIQS_PARAMETERS[0]);
+    if (bits <= SIQS_PARAMETERS[0U].bits) {
+        return SIQS_PARAMETERS[0U];
+    }
+    if (bits >= SIQS_PARAMETERS[rows - 1U].bits) {
+        return SIQS_PARAMETERS[rows - 1U];
+    }
+    size_t i = 1U;
+    while (SIQS_PARAMETERS[i].bits < bits) {
+        ++i;
+    }
+    const SiqsParameters& lo = SIQS_PARAMETERS[i - 1U];
+    const SiqsParameters& hi = SIQS_PARAMETERS[i];
+    const double t = (double)(bits - lo.bits) / (double)(hi.bits - lo.bits);
+    const auto mix = [&t](const uint32_t& a, const uint32_t& b) { return (uint32_t)(a + t * ((double)b - a) + 0.5); };
+    // (The interval is a whole number of blocks.)
+    const uint32_t halfInterval = mix(lo.halfInterval, hi.halfInterval);
+
+    return SiqsParameters{ bits, mix(lo.factorBaseSize, hi.factorBaseSize),
+        (uint32_t)(((halfInterval + (SIQS_BLOCK >> 1U) - 1U) / (SIQS_BLOCK >> 1U)) * (SIQS_BLOCK >> 1U)),
+        mix(lo.largePrimeMultiplier, hi.largePrimeMultiplier) };
+}
+
+// Modular arithmetic on factor base primes, (all below 2^32)
+inline uint32_t siqsPowMod(uint64_t b, uint64_t e, const uint32_t& m)
+{
+    uint64_t r = 1U;
+    b %= m;
+    while (e) {
+        if (e & 1U) {
+            r = (r * b) % m;
+        }
+        b = (b * b) % m;
+        e >>= 1U;
+    }
+
+    return (uint32_t)r;
+}
+
+inline uint32_t siqsInverse(const uint32_t& a, const uint32_t& m)
+{
+    int64_t t = 0, nt = 1, r = m, nr = a % m;
+    while (nr) {
+        const int64_t q = r / nr;
+        int64_t tmp = t - q * nt;
+        t = nt;
+        nt = tmp;
+        tmp = r - q * nr;
+        r = nr;
+        nr = tmp;
+    }
+
+    return (uint32_t)((t < 0) ? (t + m) : t);
+}
+
+// A square root of "a," a quadratic residue modulo the odd prime "p," (by Tonelli-Shanks)
+inline uint32_t siqsSqrtMod(const uint32_t& a, const uint32_t& p)
+{
+    if (!a) {
+        return 0U;
+    }
+    if ((p & 3U) == 3U) {
+        return siqsPowMod(a, (p + 1U) >> 2U, p);
+    }
+    uint32_t q = p - 1U, s = 0U;
+    while (!(q & 1U)) {
+        q >>= 1U;
+        ++s;
+    }
+    uint32_t z = 2U;
+    while (siqsPowMod(z, (p - 1U) >> 1U, p) != (p - 1U)) {
+        ++z;
+    }
+    uint64_t c = siqsPowMod(z, q, p), r = siqsPowMod(a, (q + 1U) >> 1U, p), t = siqsPowMod(a, q, p);
+    uint32_t m = s;
+    while (t != 1U) {
+        uint32_t i = 0U;
+        for (uint64_t tt = t; tt != 1U; tt = (tt * tt) % p) {
+            ++i;
+        }
+        uint64_t b = c;
+        for (uint32_t j = i + 1U; j < m; ++j) {
+            b = (b * b) % p;
+        }
+        m = i;
+        c = (b * b) % p;
+        t = (t * c) % p;
+        r = (r * b) % p;
+    }
+
+    return (uint32_t)r;
+}
+
+// Add a signed value to another, as (magnitude, sign) pairs, (since the integer types are unsigned)
+template <typename BigInteger>
+inline void siqsAdd(BigInteger& mag, bool& isNeg, const BigInteger& addMag, const bool& isAddNeg)
+{
+    if (isNeg == isAddNeg) {
+        mag = mag + addMag;
+    } else if (addMag < mag) {
+        mag = mag - addMag;
+    } else {
+        mag = addMag - mag;
+        isNeg = isAddNeg;
+    }
+}
+
+struct SiqsPrime {
+    uint32_t prime;
+    // A square root of kN, modulo the prime
+    uint32_t root;
+    // Scaled log2 of the prime, for the sieve
+    uint8_t log;
+    // Sieved, (or only trial divided)
+    bool isSieved;
+};
+
+template <typename BigInteger> struct SiqsRelation {
+    // |Ax + B| (mod N,) or a product of two, for a combined pair
+    BigInteger y;
+    // Factor base indices, with multiplicity, of y^2 (mod N,) (where index 0 stands for -1)
+    std::vector<uint32_t> factors;
+    // The large prime shared by a combined pair, (which y^2 holds squared,) or 1, for a full relation
+    uint64_t largePrime;
+};
+
+// Relations from all workers
+template <typename BigInteger> struct SiqsRelationStore {
+    std::mutex storeMutex;
+    std::vector<SiqsRelation<BigInteger>> relations;
+    // Partial relations, by large prime, until another with the same large prime turns up
+    std::map<uint64_t, SiqsRelation<BigInteger>> partials;
+    // (Hashes of) each "A" used so far, so no two workers sieve the same polynomials
+    std::set<uint64_t> usedA;
+    size_t target;
+    size_t fullCount;
+    size_t pairCount;
+    size_t polynomialCount;
+    // Next relation count to report progress at
+    size_t nextReport;
+    std::atomic<bool> isFull;
+
+    SiqsRelationStore(const size_t& t)
+        : target(t)
+        , fullCount(0U)
+        , pairCount(0U)
+        , polynomialCount(0U)
+        , nextReport(t / 10U)
+        , isFull(false)
+    {
+        // Intentionally left blank.
+    }
+
+    // Collect "count" more relations.
+    void extend(const size_t& count)
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        target += count;
+        nextReport = relations.size() + (target / 10U);
+        isFull = false;
+    }
+
+    bool claimA(const uint64_t& hash)
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        return usedA.insert(hash).second;
+    }
+
+    // Add a relation, (or a partial, combining it with an earlier one if it can,) and return
+    // whether to report progress.
+    bool add(SiqsRelation<BigInteger>&& relation, const uint64_t& largePrime, const BigInteger& toFactor)
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        if (isFull) {
+            return false;
+        }
+        if (largePrime == 1U) {
+            relations.push_back(std::move(relation));
+            ++fullCount;
+        } else {
+            const auto it = partials.find(largePrime);
+            if (it == partials.end()) {
+                partials.emplace(largePrime, std::move(relation));
+                return false;
+            }
+            SiqsRelation<BigInteger> pair;
+            pair.y = (it->second.y * relation.y) % toFactor;
+            pair.factors = it->second.factors;
+            pair.factors.insert(pair.factors.end(), relation.factors.begin(), relation.factors.end());
+            pair.largePrime = largePrime;
+            relations.push_back(std::move(pair));
+            ++pairCount;
+        }
+        if (relations.size() >= target) {
+            isFull = true;
+        }
+        if (relations.size() >= nextReport) {
+            nextReport += target / 10U;
+            return true;
+        }
+
+        return false;
+    }
+
+    std::string progress(const double& seconds)
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        std::stringstream ss;
+        ss << "[siqs] " << relations.size() << "/" << target << " relations (" << fullCount << " full, " << pairCount
+           << " from " << partials.size() << " partials), " << polynomialCount << " polynomials, " << seconds << "s";
+
+        return ss.str();
+    }
+};
+
+template <typename BigInteger> struct SiqsEngine {
+    const BigInteger toFactor;
+    uint32_t multiplier;
+    BigInteger kN;
+    SiqsParameters parameters;
+    // Index 0 stands for -1.
+    std::vector<SiqsPrime> factorBase;
+    uint64_t largePrimeBound;
+    // Sieve bytes start here, so those that reach the threshold have their high bit set.
+    uint8_t sieveInit;
+    // Primes per "A," and the factor base indices to choose them from
+    size_t aPrimeCount;
+    double aTargetLog2;
+    std::vector<uint32_t> aPool;
+
+    SiqsEngine(const BigInteger& n)
+        : toFactor(n)
+        , multiplier(1U)
+        , largePrimeBound(0U)
+        , sieveInit(0U)
+        , aPrimeCount(1U)
+        , aTargetLog2(0.0)
+    {
+        // Intentionally left blank.
+    }
+
+    // Knuth-Schroeppel: the expected contribution of small primes to the smoothness of Q, less the
+    // cost of a larger kN
+    void chooseMultiplier(const std::vector<uint32_t>& smallPrimes)
+    {
+        double best = -DBL_MAX;
+        for (const uint32_t& k : SIQS_MULTIPLIERS) {
+            const uint32_t kn8 = (uint32_t)((k * (uint64_t)(uint32_t)(toFactor % 8U)) & 7U);
+            double score = -0.5 * std::log((double)k) + ((kn8 == 1U) ? 2.0 : ((kn8 == 5U) ? 1.0 : 0.5)) * std::log(2.0);
+            for (const uint32_t& p : smallPrimes) {
+                if (p == 2U) {
+                    continue;
+                }
+                if (!(k % p)) {
+                    score += std::log((double)p) / p;
+                    continue;
+                }
+                const uint32_t knp = (uint32_t)((k * (uint64_t)(uint32_t)(toFactor % p)) % p);
+                if (knp && (siqsPowMod(knp, (p - 1U) >> 1U, p) == 1U)) {
+                    score += 2.0 * std::log((double)p) / (p - 1U);
+                }
+            }
+            if (score > best) {
+                best = score;
+                multiplier = k;
+            }
+        }
+        kN = toFactor * multiplier;
+    }
+
+    // Choose the multiplier and build the factor base. Returns false, (having reported it,) if a
+    // factor base prime (or the square root) already splits N.
+    bool prepare(BatchScheduler& scheduler)
+    {
+        std::vector<uint32_t> primes = getPrimesTo(1000U);
+        chooseMultiplier(primes);
+        parameters = getSiqsParameters((uint32_t)log2(kN) + 1U);
+
+        factorBase.clear();
+        factorBase.push_back(SiqsPrime{ 1U, 0U, 0U, false });
+        size_t bound = 1000U;
+        size_t next = 0U;
+        while (factorBase.size() <= parameters.factorBaseSize) {
+            if (next >= primes.size()) {
+                bound <<= 1U;
+                primes = getPrimesTo(bound);
+            }
+            for (; (next < primes.size()) && (factorBase.size() <= parameters.factorBaseSize); ++next) {
+                const uint32_t& p = primes[next];
+                const uint32_t np = (uint32_t)(toFactor % p);
+                if (!np) {
+                    if (toFactor == p) {
+                        return true;
+                    }
+                    printSuccess<BigInteger>(p, toFactor / p, toFactor, "Factor base: Found ", scheduler);
+                    return false;
+                }
+                if (p == 2U) {
+                    // (kN is odd, so 2 divides Q exactly when "y" is odd.)
+                    factorBase.push_back(SiqsPrime{ 2U, 1U, 1U, false });
+                    continue;
+                }
+                if (!(multiplier % p)) {
+                    factorBase.push_back(SiqsPrime{ p, 0U, 0U, false });
+                    continue;
+                }
+                const uint32_t knp = (uint32_t)(((uint64_t)multiplier * np) % p);
+                if (siqsPowMod(knp, (p - 1U) >> 1U, p) != 1U) {
+                    continue;
+                }
+                factorBase.push_back(SiqsPrime{ p, siqsSqrtMod(knp, p), 0U, p >= SIQS_MIN_SIEVE_PRIME });
+            }
+        }
+        const uint64_t largest = factorBase.back().prime;
+        largePrimeBound = std::min(largest * parameters.largePrimeMultiplier, largest * largest - 1U);
+
+        // |g(x)| is at most about M sqrt(kN / 2), and we accept a cofactor up to the large prime bound,
+        // less a margin, (for the unsieved small primes, and |g(x)| being smaller over most of the interval).
+        const double kNLog2 = (double)log2(kN);
+        const double gLog2 = std::log2((double)parameters.halfInterval) + 0.5 * (kNLog2 - 1.0);
+        const double thresholdLog2 = gLog2 - std::log2((double)largePrimeBound) - SIQS_THRESHOLD_MARGIN;
+        // (Scale the logarithms, so the threshold fits below the high bit of a byte.)
+        const double scale = (thresholdLog2 > 120.0) ? (120.0 / thresholdLog2) : 1.0;
+        for (SiqsPrime& fp : factorBase) {
+            if (fp.isSieved) {
+                fp.log = (uint8_t)std::lround(std::log2((double)fp.prime) * scale);
+            }
+        }
+        sieveInit = (uint8_t)(128U - (uint32_t)std::max(1L, std::lround(thresholdLog2 * scale)));
+
+        // Each "A" is "s" primes of about equal size, from the middle of the factor base.
+        aTargetLog2 = 0.5 * (kNLog2 + 1.0) - std::log2((double)parameters.halfInterval);
+        const double idealLog2 = std::log2(std::min(2000.0, (double)factorBase[factorBase.size() >> 1U].prime));
+        aPrimeCount = std::max(1L, std::lround(aTargetLog2 / idealLog2));
+        const double qLog2 = aTargetLog2 / aPrimeCount;
+        for (double width = 0.5; aPool.size() < (aPrimeCount + 3U); width *= 2.0) {
+            aPool.clear();
+            for (uint32_t i = 1U; i < factorBase.size(); ++i) {
+                const double pLog2 = std::log2((double)factorBase[i].prime);
+                if (factorBase[i].isSieved && (std::fabs(pLog2 - qLog2) <= width)) {
+                    aPool.push_back(i);
+                }
+            }
+            if (width > 64.0) {
+                break;
+            }
+        }
+
+        return !aPool.empty();
+    }
+
+    // A product of "s" factor base primes near the target size, (by their indices,) unique across workers
+    bool chooseA(std::mt19937_64& rng, SiqsRelationStore<BigInteger>& store, std::vector<uint32_t>& aIndices,
+        BigInteger& a) const
+    {
+        for (size_t attempt = 0U; attempt < 1000U; ++attempt) {
+            aIndices.clear();
+            double aLog2 = 0.0;
+            const size_t randomCount = (aPrimeCount > 1U) ? (aPrimeCount - 1U) : 1U;
+            while (aIndices.size() < randomCount) {
+                const uint32_t i = aPool[rng() % aPool.size()];
+                if (std::find(aIndices.begin(), aIndices.end(), i) == aIndices.end()) {
+                    aIndices.push_back(i);
+                    aLog2 += std::log2((double)factorBase[i].prime);
+                }
+            }
+            if (aPrimeCount > 1U) {
+                // The last prime brings the product closest to the target.
+                const double want = std::exp2(aTargetLog2 - aLog2);
+                uint32_t best = 0U;
+                double bestDistance = DBL_MAX;
+                for (uint32_t i = 1U; i < factorBase.size(); ++i) {
+                    const double distance = std::fabs(factorBase[i].prime - want);
+                    if (factorBase[i].isSieved && (distance < bestDistance) &&
+                        (std::find(aIndices.begin(), aIndices.end(), i) == aIndices.end())) {
+                        best = i;
+                        bestDistance = distance;
+                    }
+                }
+                if (!best) {
+                    continue;
+                }
+                aIndices.push_back(best);
+            }
+            std::sort(aIndices.begin(), aIndices.end());
+
+            a = 1U;
+            uint64_t hash = 1469598103934665603ULL;
+            for (const uint32_t& i : aIndices) {
+                a = a * factorBase[i].prime;
+                hash = (hash ^ i) * 1099511628211ULL;
+            }
+            if (store.claimA(hash)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Sieve polynomials, (each worker its own "A,") until the store is full, or the scheduler stops.
+    void run(const size_t& worker, const size_t& nodeId, SiqsRelationStore<BigInteger>& store,
+        BatchScheduler& scheduler) const
+    {
+        std::mt19937_64 rng(0x9E3779B97F4A7C15ULL * (1U + worker) + 0xBF58476D1CE4E5B9ULL * nodeId);
+        const size_t fbSize = factorBase.size();
+        const uint32_t halfInterval = parameters.halfInterval;
+        const uint32_t interval = halfInterval << 1U;
+        std::vector<uint8_t> sieve(SIQS_BLOCK);
+        std::vector<uint32_t> root1(fbSize), root2(fbSize), next1(fbSize), next2(fbSize);
+        std::vector<uint32_t> bainv;
+        std::vector<uint8_t> isSieved(fbSize);
+        std::vector<uint32_t> aIndices;
+        std::vector<BigInteger> bTerms;
+        std::vector<uint32_t> factors;
+        BigInteger a;
+
+        while (!store.isFull && !scheduler.isStopped()) {
+            if (!chooseA(rng, store, aIndices, a)) {
+                return;
+            }
+            const size_t s = aIndices.size();
+
+            // B = sum of B_l, with B_l = 0 (mod q_j) for j != l, and B_l^2 = kN (mod q_l)
+            bTerms.resize(s);
+            for (size_t l = 0U; l < s; ++l) {
+                const SiqsPrime& q = factorBase[aIndices[l]];
+                const BigInteger aq = a / q.prime;
+                uint64_t gamma = ((uint64_t)q.root * siqsInverse((uint32_t)(aq % q.prime), q.prime)) % q.prime;
+                if (gamma > (q.prime >> 1U)) {
+                    gamma = q.prime - gamma;
+                }
+                bTerms[l] = aq * (BigInteger)gamma;
+            }
+            BigInteger b = 0U;
+            for (const BigInteger& t : bTerms) {
+                b = b + t;
+            }
+            bool isBNeg = false;
+
+            // Roots of g(x), as offsets into the interval, and their changes for each next "B"
+            bainv.assign(s * fbSize, 0U);
+            for (size_t i = 1U; i < fbSize; ++i) {
+                const SiqsPrime& fp = factorBase[i];
+                isSieved[i] = fp.isSieved && !std::binary_search(aIndices.begin(), aIndices.end(), (uint32_t)i);
+                if (!isSieved[i]) {
+                    continue;
+                }
+                const uint32_t p = fp.prime;
+                const uint64_t aInv = siqsInverse((uint32_t)(a % p), p);
+                uint64_t bMod = 0U;
+                for (size_t l = 0U; l < s; ++l) {
+                    const uint64_t tMod = (uint32_t)(bTerms[l] % p);
+                    bMod += tMod;
+                    bainv[l * fbSize + i] = (uint32_t)((2U * tMod * aInv) % p);
+                }
+                bMod %= p;
+                const uint64_t mMod = halfInterval % p;
+                root1[i] = (uint32_t)(((((fp.root + p - bMod) % p) * aInv) + mMod) % p);
+                root2[i] = (uint32_t)(((((2U * p - fp.root - bMod) % p) * aInv) + mMod) % p);
+            }
+
+            const size_t polynomials = (size_t)1U << (s - 1U);
+            for (size_t poly = 0U; poly < polynomials; ++poly) {
+                if (poly) {
+                    if (store.isFull || scheduler.isStopped()) {
+                        break;
+                    }
+                    // Gray code: B changes by +/-2 B_l, for the lowest set bit "l."
+                    size_t l = 0U;
+                    while (!((poly >> l) & 1U)) {
+                        ++l;
+                    }
+                    const bool isPlus = (poly >> (l + 1U)) & 1U;
+                    siqsAdd(b, isBNeg, (BigInteger)(bTerms[l] << 1U), !isPlus);
+                    const uint32_t* delta = &bainv[l * fbSize];
+                    for (size_t i = 1U; i < fbSize; ++i) {
+                        if (!isSieved[i]) {
+                            continue;
+                        }
+                        const uint32_t p = factorBase[i].prime;
+                        // (A root moves by -(change in B) / A.)
+                        const uint32_t up = isPlus ? (p - delta[i]) : delta[i];
+                        root1[i] += up;
+                        root1[i] -= (root1[i] >= p) ? p : 0U;
+                        root2[i] += up;
+                        root2[i] -= (root2[i] >= p) ? p : 0U;
+                    }
+                }
+
+                for (size_t i = 1U; i < fbSize; ++i) {
+                    next1[i] = root1[i];
+                    next2[i] = root2[i];
+                }
+                for (uint32_t blockStart = 0U; blockStart < interval; blockStart += SIQS_BLOCK) {
+                    const uint32_t blockEnd = blockStart + SIQS_BLOCK;
+                    std::memset(sieve.data(), sieveInit, SIQS_BLOCK);
+                    for (size_t i = 1U; i < fbSize; ++i) {
+                        if (!isSieved[i]) {
+                            continue;
+                        }
+                        const uint32_t p = factorBase[i].prime;
+                        const uint8_t lg = factorBase[i].log;
+                        uint32_t o = next1[i];
+                        for (; o < blockEnd; o += p) {
+                            sieve[o - blockStart] += lg;
+                        }
+                        next1[i] = o;
+                        o = next2[i];
+                        for (; o < blockEnd; o += p) {
+                            sieve[o - blockStart] += lg;
+                        }
+                        next2[i] = o;
+                    }
+
+                    // Scan a word at a time for bytes with the high bit set.
+                    for (size_t w = 0U; w < SIQS_BLOCK; w += 8U) {
+                        uint64_t word;
+                        std::memcpy(&word, &sieve[w], 8U);
+                        if (!(word & 0x8080808080808080ULL)) {
+                            continue;
+                        }
+                        for (size_t j = 0U; j < 8U; ++j) {
+                            if (sieve[w + j] & 0x80U) {
+                                checkCandidate(blockStart + (uint32_t)(w + j), a, aIndices, b, isBNeg, root1, root2,
+                                    isSieved, factors, store, scheduler);
+                            }
+                        }
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(store.storeMutex);
+                    ++store.polynomialCount;
+                }
+            }
+        }
+    }
+
+    // Trial divide g(x), at offset "o" into the interval, over the factor base, and keep it if it's smooth.
+    void checkCandidate(const uint32_t& o, const BigInteger& a, const std::vector<uint32_t>& aIndices,
+        const BigInteger& b, const bool& isBNeg, const std::vector<uint32_t>& root1, const std::vector<uint32_t>& root2,
+        const std::vector<uint8_t>& isSieved, std::vector<uint32_t>& factors, SiqsRelationStore<BigInteger>& store,
+        BatchScheduler& scheduler) const
+    {
+        // y = Ax + B, and Q = y^2 - kN = A g(x)
+        const bool isXNeg = o < parameters.halfInterval;
+        const uint32_t xMag = isXNeg ? (parameters.halfInterval - o) : (o - parameters.halfInterval);
+        BigInteger y = a * (BigInteger)xMag;
+        bool isYNeg = isXNeg;
+        siqsAdd(y, isYNeg, b, isBNeg);
+        const BigInteger ySqr = y * y;
+        const bool isGNeg = ySqr < kN;
+        BigInteger g = (isGNeg ? (kN - ySqr) : (ySqr - kN)) / a;
+        if (g == 0U) {
+            return;
+        }
+
+        factors.clear();
+        if (isGNeg) {
+            factors.push_back(0U);
+        }
+        for (const uint32_t& i : aIndices) {
+            factors.push_back(i);
+        }
+        for (size_t i = 1U; i < factorBase.size(); ++i) {
+            const uint32_t p = factorBase[i].prime;
+            if (isSieved[i]) {
+                const uint32_t r = o % p;
+                if ((r != root1[i]) && (r != root2[i])) {
+                    continue;
+                }
+            }
+            while ((g % p) == 0U) {
+                g = g / p;
+                factors.push_back((uint32_t)i);
+            }
+        }
+
+        uint64_t largePrime = 1U;
+        if (g != 1U) {
+            if (!(g < (BigInteger)largePrimeBound)) {
+                return;
+            }
+            largePrime = (uint64_t)g;
+            if ((toFactor % largePrime) == 0U) {
+                printSuccess<BigInteger>(largePrime, toFactor / largePrime, toFactor, "Large prime: Found ", scheduler);
+                return;
+            }
+        }
+
+        SiqsRelation<BigInteger> relation;
+        relation.y = y % toFactor;
+        relation.factors = factors;
+        relation.largePrime = 1U;
+        if (store.add(std::move(relation), largePrime, toFactor) && !scheduler.isQuiet) {
+            std::cout << store.progress(scheduler.elapsed()) << std::endl;
+        }
+    }
+};
+
+// Collect relations on "workerCount" threads, until there are enough, (or "scheduler" stops us).
+// Returns false, (with nothing collected,) if the engine found a factor, or doesn't apply.
+template <typename BigInteger>
+bool collectSiqsRelations(const SiqsEngine<BigInteger>& engine, const size_t& nodeId, const unsigned& workerCount,
+    SiqsRelationStore<BigInteger>& store, BatchScheduler& scheduler)
+{
+    std::vector<std::future<void>> futures;
+    futures.reserve(workerCount);
+    for (unsigned w = 0U; w < workerCount; ++w) {
+        futures.push_back(std::async(std::launch::async, [&engine, &store, &scheduler, w, nodeId]() {
+            engine.run(w, nodeId, store, scheduler);
+        }));
+    }
+    for (std::future<void>& future : futures) {
+        future.get();
+    }
+
+    return store.isFull;
+}
+
+// Combine the relations into congruences of squares, and try each for a factor. Returns whether one split N.
+template <typename BigInteger>
+bool findSiqsFactor(const SiqsEngine<BigInteger>& engine, SiqsRelationStore<BigInteger>& store,
+    const unsigned& workerCount, BatchScheduler& scheduler)
+{
+    const BigInteger& toFactor = engine.toFactor;
+    const size_t fbSize = engine.factorBase.size();
+    Gf2Matrix matrix(fbSize);
+    for (const SiqsRelation<BigInteger>& relation : store.relations) {
+        matrix.addRow(relation.factors);
+    }
+    const double start = scheduler.elapsed();
+    const std::vector<std::vector<uint32_t>> dependencies =
+        matrix.findDependencies(workerCount, SIQS_DEPENDENCIES, scheduler);
+    if (!scheduler.isQuiet) {
+        std::cout << "[siqs] " << dependencies.size() << " dependencies, from " << matrix.filteredRows << " x "
+                  << matrix.filteredColumns << " after filtering, (of " << store.relations.size() << " x "
+                  << (fbSize - 1U) << ",) in " << (scheduler.elapsed() - start) << "s" << std::endl;
+    }
+
+    std::vector<uint32_t> exponents(fbSize);
+    for (const std::vector<uint32_t>& dependency : dependencies) {
+        if (scheduler.isStopped()) {
+            return false;
+        }
+        // x^2 is the product of the relations' "Q," which is y^2, with every exponent even.
+        BigInteger x = 1U, y = 1U;
+        std::fill(exponents.begin(), exponents.end(), 0U);
+        for (const uint32_t& i : dependency) {
+            const SiqsRelation<BigInteger>& relation = store.relations[i];
+            x = (x * relation.y) % toFactor;
+            for (const uint32_t& j : relation.factors) {
+                ++exponents[j];
+            }
+            if (relation.largePrime != 1U) {
+                y = (y * (BigInteger)relation.largePrime) % toFactor;
+            }
+        }
+        // (Index 0 stands for -1, and an even power of it is 1.)
+        for (size_t j = 1U; j < fbSize; ++j) {
+            for (uint32_t e = 0U; e < (exponents[j] >> 1U); ++e) {
+                y = (y * engine.factorBase[j].prime) % toFactor;
+            }
+        }
+        for (const BigInteger& d : { (BigInteger)((x < y) ? (y - x) : (x - y)), (BigInteger)((x + y) % toFactor) }) {
+            const BigInteger f = gcd(d, toFactor);
+            if ((f > 1U) && (f < toFactor)) {
+                printSuccess<BigInteger>(f, toFactor / f, toFactor, "SIQS: Found ", scheduler);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+} // namespace Qimcifa
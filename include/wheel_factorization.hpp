@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Shared wheel factorization tables, for qimcifa and prime_generator.
+//
+// Both programs enumerate "backward" indices, (i.e., the dense index space of numbers that are
+// not multiples of 2 or 3,) and skip the indices that are multiples of the remaining wheel primes.
+// Rather than rotating one bit set per wheel prime for every step, we build, once per level, the
+// table of gaps between consecutive wheel survivors over one full wheel period. Every thread then
+// only advances a cursor into the shared (read-only) table, at constant cost per candidate.
+//
+// Tables grow with the primorial, (the level 8 table would take 1.6 MB, and level 10 a gigabyte,)
+// so levels above MAX_WHEEL_TABLE_LEVEL are composed on the fly, instead. By the Chinese remainder
+// theorem, the wheel of a larger primorial is the product of the stored wheel and one residue
+// ring per extra prime, so its survivors are exactly the stored wheel's survivors whose residues
+// modulo each extra prime are nonzero. Each iterator tracks those few residues incrementally, (an
+// add and a conditional subtraction or two per extra prime, per step,) alongside its cursor into
+// the stored table, which stays in cache.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace Qimcifa {
+
+// Level 7 is the wheel of 2 * 3 * 5 * 7 * 11 * 13 * 17 = 510510, the largest with a stored table.
+constexpr size_t MAX_WHEEL_TABLE_LEVEL = 7U;
+// Level 10 is the wheel of 29# = 6469693230, composed from the level 7 table.
+constexpr size_t MAX_WHEEL_LEVEL = 10U;
+constexpr size_t MAX_WHEEL_EXTRA_PRIMES = MAX_WHEEL_LEVEL - MAX_WHEEL_TABLE_LEVEL;
+constexpr size_t WHEEL_TABLE_PRIMES[MAX_WHEEL_LEVEL] = { 2U, 3U, 5U, 7U, 11U, 13U, 17U, 19U, 23U, 29U };
+
+inline size_t wheelForward(const size_t& b) {
+    // Same as "forward()," for native words: (3 * b) - 1 - (b & 1)
+    return (b << 1U) + (b & ~(size_t)1U) - 1U;
+}
+
+// Gaps between consecutive survivors, starting from backward index 1, (which is always a survivor,)
+// and wrapping around at the end of the wheel period.
+inline std::vector<unsigned char> wheel_gaps(const size_t& level) {
+    if (level > MAX_WHEEL_TABLE_LEVEL) {
+        throw std::invalid_argument("Wheel table level exceeds maximum of 7!");
+    }
+
+    if (level < 3U) {
+        // Every backward index survives.
+        return std::vector<unsigned char>(1U, 1U);
+    }
+
+    // The period, in backward index space, is the primorial divided by 2 * 3, times 2.
+    size_t period = 1U;
+    for (size_t i = 2U; i < level; ++i) {
+        period *= WHEEL_TABLE_PRIMES[i];
+    }
+    period <<= 1U;
+
+    std::vector<unsigned char> gaps;
+    size_t last = 1U;
+    for (size_t b = 2U; b <= (period + 1U); ++b) {
+        const size_t p = wheelForward(b);
+        bool isMultiple = false;
+        for (size_t i = 2U; i < level; ++i) {
+            if ((p % WHEEL_TABLE_PRIMES[i]) == 0U) {
+                isMultiple = true;
+                break;
+            }
+        }
+        if (isMultiple) {
+            continue;
+        }
+        gaps.push_back((unsigned char)(b - last));
+        last = b;
+    }
+
+    return gaps;
+}
+
+// Tables are built once per level, per process, and shared between all threads. (Composed levels
+// share the largest stored table.)
+inline const std::vector<unsigned char>& getWheelGaps(const size_t& level) {
+    static std::mutex wheelMutex;
+    static std::map<size_t, std::unique_ptr<const std::vector<unsigned char>>> wheelTables;
+
+    if (level > MAX_WHEEL_LEVEL) {
+        throw std::invalid_argument("Wheel level exceeds maximum of 10!");
+    }
+    const size_t tableLevel = (level < MAX_WHEEL_TABLE_LEVEL) ? level : MAX_WHEEL_TABLE_LEVEL;
+
+    std::lock_guard<std::mutex> lock(wheelMutex);
+    std::unique_ptr<const std::vector<unsigned char>>& table = wheelTables[tableLevel];
+    if (!table) {
+        table.reset(new std::vector<unsigned char>(wheel_gaps(tableLevel)));
+    }
+
+    return *table;
+}
+
+// Largest forward index step over one gap of the level 7 table, (whose gaps are at most 9)
+constexpr uint32_t MAX_WHEEL_TABLE_STEP = 3U * 9U + 1U;
+
+// The residue ring of a composed level: the product of its extra primes, (beyond the stored table,)
+// doubled if need be, so that a step over one table gap is smaller than it, (or 1, for a stored table)
+inline uint32_t getWheelExtraModulus(const size_t& level)
+{
+    uint32_t modulus = 1U;
+    for (size_t i = MAX_WHEEL_TABLE_LEVEL; i < level; ++i) {
+        modulus *= (uint32_t)WHEEL_TABLE_PRIMES[i];
+    }
+    if ((level > MAX_WHEEL_TABLE_LEVEL) && (modulus <= MAX_WHEEL_TABLE_STEP)) {
+        modulus <<= 1U;
+    }
+
+    return modulus;
+}
+
+// Whether each residue of the ring is coprime to the extra primes, (at most 12673 entries,) built once
+// per level, per process, and shared between all threads
+inline const std::vector<unsigned char>& getWheelCoprimes(const size_t& level) {
+    static std::mutex coprimeMutex;
+    static std::map<size_t, std::unique_ptr<const std::vector<unsigned char>>> coprimeTables;
+
+    std::lock_guard<std::mutex> lock(coprimeMutex);
+    std::unique_ptr<const std::vector<unsigned char>>& table = coprimeTables[level];
+    if (!table) {
+        const uint32_t modulus = getWheelExtraModulus(level);
+        std::vector<unsigned char> coprimes(modulus, 1U);
+        for (size_t i = MAX_WHEEL_TABLE_LEVEL; i < level; ++i) {
+            for (uint32_t r = 0U; r < modulus; r += (uint32_t)WHEEL_TABLE_PRIMES[i]) {
+                coprimes[r] = 0U;
+            }
+        }
+        table.reset(new std::vector<unsigned char>(coprimes));
+    }
+
+    return *table;
+}
+
+struct WheelIterator {
+    const unsigned char* gaps;
+    size_t size;
+    size_t cursor;
+    // For a composed level, the product of the extra primes, (or 1, for a stored table,) and which of
+    // its residues are coprime to it
+    uint32_t modulus;
+    const unsigned char* coprimes;
+    // Forward index of the current candidate, modulo "modulus," and its backward index parity
+    uint32_t residue;
+    bool isOdd;
+
+    WheelIterator(const std::vector<unsigned char>& g, const size_t& level = 0U)
+        : gaps(g.data())
+        , size(g.size())
+        , cursor(0U)
+        , modulus(getWheelExtraModulus(level))
+        , coprimes((level > MAX_WHEEL_TABLE_LEVEL) ? getWheelCoprimes(level).data() : nullptr)
+        , residue(1U)
+        , isOdd(true)
+    {
+        if (level > MAX_WHEEL_LEVEL) {
+            throw std::invalid_argument("Wheel level exceeds maximum of 10!");
+        }
+    }
+
+    WheelIterator(const size_t& level)
+        : WheelIterator(getWheelGaps(level), level)
+    {
+        // Intentionally left blank.
+    }
+
+    // Return to backward index 1, (or any other multiple of the wheel period, plus 1).
+    inline void reset()
+    {
+        cursor = 0U;
+        // forward(1) = 1
+        residue = 1U;
+        isOdd = true;
+    }
+
+    // Return to backward index "start," (a multiple of the stored table's period, plus 1, or the
+    // same offset from one as the search uses throughout,) anywhere in a composed wheel's period.
+    template <typename BigInteger> inline void reset(const BigInteger& start)
+    {
+        cursor = 0U;
+        if (!coprimes) {
+            return;
+        }
+        // forward(b) = 3b - 1 - (b & 1)
+        isOdd = (size_t)(start % 2U) != 0U;
+        residue = (uint32_t)((3U * (size_t)(start % modulus) + 2U * modulus - 1U - isOdd) % modulus);
+    }
+
+    // Distance, in backward index space, to the next wheel survivor
+    inline size_t next()
+    {
+        size_t gap = nextTableGap();
+        if (!coprimes) {
+            return gap;
+        }
+
+        size_t total = gap;
+        while (!advanceResidue(gap)) {
+            gap = nextTableGap();
+            total += gap;
+        }
+
+        return total;
+    }
+
+    inline size_t nextTableGap()
+    {
+        const size_t gap = gaps[cursor];
+        if (++cursor == size) {
+            cursor = 0U;
+        }
+
+        return gap;
+    }
+
+    // Step the residue over one table gap, and return whether the new candidate survives the extra
+    // primes.
+    inline bool advanceResidue(const size_t& gap)
+    {
+        // forward(b + g) - forward(b) = 3g + (b & 1) - ((b + g) & 1)
+        const bool wasOdd = isOdd;
+        isOdd = isOdd ^ ((gap & 1U) != 0U);
+        // (A step is smaller than the modulus, so one conditional subtraction reduces it.)
+        const uint32_t r = residue + (uint32_t)(3U * gap + wasOdd - isOdd);
+        residue = (r >= modulus) ? (r - modulus) : r;
+
+        return coprimes[residue] != 0U;
+    }
+};
+} // namespace Qimcifa
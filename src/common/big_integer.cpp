@@ -192,7 +192,8 @@ void bi_div_mod(const BigInteger& left, const BigInteger& right, BigInteger* quo
     BigInteger bi1 = 1U;
     int rightLog2 = bi_log2(right);
     BigInteger rightTest = bi1 << rightLog2;
-    if (bi_compare(right, rightTest) < 0) {
+    // (Round up, so a shifted "right" never exceeds the remainder.)
+    if (bi_compare(right, rightTest) > 0) {
         ++rightLog2;
     }
     BigInteger rem;
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// (C) Daniel Strano and the Qrack contributors 2017-2024. All rights reserved.
+//
+// Benchmark of the integer square root, "isqrt," against the bisection it replaced, at each bit
+// width the build's widest integer type can square without overflow, (which bisection needs,) and
+// for native 64-bit words. Every root is checked, (r^2 <= N < (r + 1)^2,) and any disagreement is
+// reported.
+//
+// Licensed under the GNU Lesser General Public License V3.
+// See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
+// for details.
+
+#include "qimcifa.hpp"
+
+#include <random>
+
+namespace Qimcifa {
+
+// Floor of the square root, by bisection, (as qimcifa and prime_generator had it,) for comparison
+template <typename BigInteger> BigInteger bisectionSqrt(const BigInteger& toTest)
+{
+    BigInteger start = 1U, end = toTest >> 1U, ans = 0U;
+    do {
+        const BigInteger mid = (start + end) >> 1U;
+        const BigInteger sqr = mid * mid;
+        if (sqr == toTest) {
+            return mid;
+        }
+        if (sqr < toTest) {
+            start = mid + 1U;
+            ans = mid;
+        } else {
+            end = mid - 1U;
+        }
+    } while (start <= end);
+
+    return ans;
+}
+
+// Random integers of exactly "bits" bits
+template <typename BigInteger> std::vector<BigInteger> getSamples(const uint32_t& bits, const size_t& count)
+{
+    std::mt19937_64 rng(bits);
+    std::vector<BigInteger> samples;
+    samples.reserve(count);
+    for (size_t i = 0U; i < count; ++i) {
+        BigInteger n = 1U;
+        for (uint32_t b = 1U; b < bits; b += 32U) {
+            const uint32_t width = std::min(32U, bits - b);
+            n = (n << width) | (BigInteger)(uint64_t)(rng() >> (64U - width));
+        }
+        samples.push_back(n);
+    }
+
+    return samples;
+}
+
+// Seconds per root, for each of the two routines, and whether every root was right
+template <typename BigInteger>
+void benchmark(const std::string& name, const uint32_t& bits, const size_t& count, const bool& isBisectionSafe)
+{
+    const std::vector<BigInteger> samples = getSamples<BigInteger>(bits, count);
+    std::vector<BigInteger> roots(count), oldRoots(count);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0U; i < count; ++i) {
+        roots[i] = isqrt(samples[i]);
+    }
+    const double newTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0U; i < count; ++i) {
+        oldRoots[i] = bisectionSqrt(samples[i]);
+    }
+    const double oldTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    size_t wrong = 0U, disagree = 0U;
+    for (size_t i = 0U; i < count; ++i) {
+        const BigInteger& r = roots[i];
+        const BigInteger next = r + 1U;
+        // (Compare the root, instead of squaring it, where a square could overflow.)
+        if ((samples[i] / r) < r || !((samples[i] / next) < next)) {
+            ++wrong;
+        }
+        if (oldRoots[i] != r) {
+            ++disagree;
+        }
+    }
+
+    std::cout << std::setw(10) << name << std::setw(7) << bits << std::setw(14) << std::setprecision(4)
+              << (1e6 * newTime / count) << std::setw(14) << (1e6 * oldTime / count) << std::setw(10)
+              << (oldTime / newTime) << "x";
+    if (wrong) {
+        std::cout << "  (" << wrong << " wrong!)";
+    }
+    if (disagree) {
+        std::cout << "  (" << disagree << " bisection roots differ" << (isBisectionSafe ? "!)" : ", by overflow)");
+    }
+    std::cout << std::endl;
+}
+} // namespace Qimcifa
+
+using namespace Qimcifa;
+
+int main(int argc, char* argv[])
+{
+    size_t count = 1000U;
+    if (argc > 1) {
+        count = std::strtoull(argv[1], nullptr, 10);
+    }
+    if (!count) {
+        std::cout << "Usage: " << argv[0] << " [samples per width]" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "type" << std::setw(7) << "bits" << std::setw(14) << "isqrt (us)"
+              << std::setw(14) << "bisect (us)" << std::setw(11) << "speedup" << std::endl;
+
+    // (Bisection squares up to N / 2, so it overflows past 32 bits, here.)
+    benchmark<uint64_t>("uint64", 32U, count, true);
+    benchmark<uint64_t>("uint64", 64U, count, false);
+
+#if USE_GMP
+    const uint32_t maxBits = 8192U;
+#elif USE_BOOST
+    const uint32_t maxBits = 4096U;
+#else
+    const uint32_t maxBits = BIG_INTEGER_BITS >> 1U;
+#endif
+    for (uint32_t bits = 128U; bits <= maxBits; bits <<= 1U) {
+        benchmark<BigIntegerInput>("input", bits, (bits > 1024U) ? std::max((size_t)1U, count >> 3U) : count, true);
+    }
+
+    return 0;
+}
@@ -40,8 +40,8 @@ bool isMultipleParallel(const BigInteger& p, const size_t& nextPrimeIndex, const
 
 std::vector<BigInteger> TrialDivision(const BigInteger& n)
 {
-    // First 3 primes
-    std::vector<BigInteger> knownPrimes = { 2, 3 };
+    // First 7 primes
+    std::vector<BigInteger> knownPrimes = { 2, 3, 5, 7, 11, 13, 17 };
 
     if (n < 2) {
         return std::vector<BigInteger>();
@@ -52,36 +52,29 @@ std::vector<BigInteger> TrialDivision(const BigInteger& n)
         return std::vector<BigInteger>(knownPrimes.begin(), highestPrimeIt);
     }
 
-    std::vector<size_t> wheelPrimes= { 2, 3 };
-
     // We are excluding multiples of the first few
     // small primes from outset. For multiples of
     // 2 and 3, this reduces complexity by 2/3.
+    // The rest of the first 7 are skipped by the
+    // (shared) wheel table, for 17 * 2 * 3 = 510510.
     // const BigInteger cardinality = (~((~n) | 1)) / 3;
 
     // Get the remaining prime numbers.
-    std::vector<boost::dynamic_bitset<size_t>> inc_seqs;
-    const size_t wheel_limit = 17U;
+    const size_t wheelPrimeCount = knownPrimes.size();
+    Qimcifa::WheelIterator wheel(wheelPrimeCount);
     for (BigInteger o = 1U; forward(o) < n;) {
-        o += GetWheelIncrement(inc_seqs);
+        o += wheel.next();
 
         const BigInteger p = forward(o);
         if (p > n) {
             break;
         }
-        if (isMultiple(p, wheelPrimes.size(), knownPrimes)) {
+        if (isMultiple(p, wheelPrimeCount, knownPrimes)) {
             // Skip
             continue;
         }
 
         knownPrimes.push_back(p);
-        if (p <= wheel_limit) {
-            wheelPrimes.push_back((size_t)p);
-            inc_seqs.push_back(wheel_inc(knownPrimes, n));
-            boost::dynamic_bitset<size_t>& wheel = inc_seqs.back();
-            wheel >>= 1U;
-            wheel[wheel.size() - 1U] = true;
-        }
     }
 
     return knownPrimes;
@@ -111,7 +104,7 @@ std::vector<BigInteger> SieveOfEratosthenes(const BigInteger& n)
     // reverse the true/false meaning, so we can use
     // default initialization. A value in notPrime[i]
     // will finally be false only if i is a prime.
-    std::unique_ptr<bool> uNotPrime(new bool[cardinality + 1U]());
+    std::unique_ptr<bool[]> uNotPrime(new bool[cardinality + 1U]());
     bool* notPrime = uNotPrime.get();
 
     // We dispatch multiple marking asynchronously.
@@ -235,7 +228,7 @@ BigInteger CountPrimesTo(const BigInteger& n)
     // reverse the true/false meaning, so we can use
     // default initialization. A value in notPrime[i]
     // will finally be false only if i is a prime.
-    std::unique_ptr<bool> uNotPrime(new bool[cardinality + 1U]());
+    std::unique_ptr<bool[]> uNotPrime(new bool[cardinality + 1U]());
     bool* notPrime = uNotPrime.get();
 
     // We dispatch multiple marking asynchronously.
@@ -372,7 +365,7 @@ std::vector<BigInteger> SegmentedSieveOfEratosthenes(BigInteger n)
         const BigInteger fLo = forward(low);
         const size_t sqrtIndex = std::distance(
             knownPrimes.begin(),
-            std::upper_bound(knownPrimes.begin(), knownPrimes.end(), sqrt(forward(high)) + 1U)
+            std::upper_bound(knownPrimes.begin(), knownPrimes.end(), isqrt(forward(high)) + 1U)
         );
 
         const size_t cardinality = high - low;
@@ -449,7 +442,7 @@ BigInteger SegmentedCountPrimesTo(BigInteger n)
     if (limit_simple >= n) {
         return CountPrimesTo(n);
     }
-    BigInteger sqrtnp1 = (sqrt(n) + 1U) | 1U;
+    BigInteger sqrtnp1 = (isqrt(n) + 1U) | 1U;
     if ((sqrtnp1 % 3U) == 0U) {
         sqrtnp1 += 2U;
     }
@@ -474,7 +467,7 @@ BigInteger SegmentedCountPrimesTo(BigInteger n)
         const BigInteger fLo = forward(low);
         const size_t sqrtIndex = std::distance(
             knownPrimes.begin(),
-            std::upper_bound(knownPrimes.begin(), knownPrimes.end(), sqrt(forward(high)) + 1U)
+            std::upper_bound(knownPrimes.begin(), knownPrimes.end(), isqrt(forward(high)) + 1U)
         );
 
         const size_t cardinality = high - low;
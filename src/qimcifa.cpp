@@ -54,164 +54,162 @@
 // See LICENSE.md in the project root or https://www.gnu.org/licenses/lgpl-3.0.en.html
 // for details.
 
+#include "batch_gcd.hpp"
+#include "calibration_store.hpp"
+#include "cpu_topology.hpp"
+#include "factorization.hpp"
+#include "fermat_search.hpp"
+#include "lease_ledger.hpp"
+#include "pollard_rho.hpp"
 #include "qimcifa.hpp"
+#include "siqs.hpp"
+
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
 
 namespace Qimcifa {
 
+// Default wheel level, without a choice or calibration file
+constexpr int64_t DEFAULT_RTD_LEVEL = 7;
+
+// Calibrated level for this number, backend, build, and CPU, (or the default, with a reason, if
+// there's no matching calibration,) and its time per batch, (negative, if uncalibrated)
 template <typename BigInteger>
-int mainBody(const BigInteger& toFactor)
+int64_t getCalibratedLevel(
+    const BigInteger& toFactor, const CalibrationStore& store, double& batchSeconds, std::string& mismatch)
 {
-    // First 1000 primes
-    // (Only 100 included in program)
-    // Source: https://gist.github.com/cblanc/46ebbba6f42f61e60666#file-gistfile1-txt
-    const std::vector<unsigned> trialDivisionPrimes = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59,
-        61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137, 139, 149, 151, 157, 163, 167, 173, 179,
-        181, 191, 193, 197, 199, 211, 223, 227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307,
-        311, 313, 317, 331, 337, 347, 349, 353, 359, 367, 373, 379, 383, 389, 397, 401, 409, 419, 421, 431, 433, 439,
-        443, 449, 457, 461, 463, 467, 479, 487, 491, 499, 503, 509, 521, 523, 541, 547, 557, 563, 569, 571, 577, 587,
-        593, 599, 601, 607, 613, 617, 619, 631, 641, 643, 647, 653, 659, 661, 673, 677, 683, 691, 701, 709, 719, 727,
-        733, 739, 743, 751, 757, 761, 769, 773, 787, 797, 809, 811, 821, 823, 827, 829, 839, 853, 857, 859, 863, 877,
-        881, 883, 887, 907, 911, 919, 929, 937, 941, 947, 953, 967, 971, 977, 983, 991, 997, 1009, 1013, 1019, 1021,
-        1031, 1033, 1039, 1049, 1051, 1061, 1063, 1069, 1087, 1091, 1093, 1097, 1103, 1109, 1117, 1123, 1129, 1151,
-        1153, 1163, 1171, 1181, 1187, 1193, 1201, 1213, 1217, 1223, 1229, 1231, 1237, 1249, 1259, 1277, 1279, 1283,
-        1289, 1291, 1297, 1301, 1303, 1307, 1319, 1321, 1327, 1361, 1367, 1373, 1381, 1399, 1409, 1423, 1427, 1429,
-        1433, 1439, 1447, 1451, 1453, 1459, 1471, 1481, 1483, 1487, 1489, 1493, 1499, 1511, 1523, 1531, 1543, 1549,
-        1553, 1559, 1567, 1571, 1579, 1583, 1597, 1601, 1607, 1609, 1613, 1619, 1621, 1627, 1637, 1657, 1663, 1667,
-        1669, 1693, 1697, 1699, 1709, 1721, 1723, 1733, 1741, 1747, 1753, 1759, 1777, 1783, 1787, 1789, 1801, 1811,
-        1823, 1831, 1847, 1861, 1867, 1871, 1873, 1877, 1879, 1889, 1901, 1907, 1913, 1931, 1933, 1949, 1951, 1973,
-        1979, 1987, 1993, 1997, 1999, 2003, 2011, 2017, 2027, 2029, 2039, 2053, 2063, 2069, 2081, 2083, 2087, 2089,
-        2099, 2111, 2113, 2129, 2131, 2137, 2141, 2143, 2153, 2161, 2179, 2203, 2207, 2213, 2221, 2237, 2239, 2243,
-        2251, 2267, 2269, 2273, 2281, 2287, 2293, 2297, 2309, 2311, 2333, 2339, 2341, 2347, 2351, 2357, 2371, 2377,
-        2381, 2383, 2389, 2393, 2399, 2411, 2417, 2423, 2437, 2441, 2447, 2459, 2467, 2473, 2477, 2503, 2521, 2531,
-        2539, 2543, 2549, 2551, 2557, 2579, 2591, 2593, 2609, 2617, 2621, 2633, 2647, 2657, 2659, 2663, 2671, 2677,
-        2683, 2687, 2689, 2693, 2699, 2707, 2711, 2713, 2719, 2729, 2731, 2741, 2749, 2753, 2767, 2777, 2789, 2791,
-        2797, 2801, 2803, 2819, 2833, 2837, 2843, 2851, 2857, 2861, 2879, 2887, 2897, 2903, 2909, 2917, 2927, 2939,
-        2953, 2957, 2963, 2969, 2971, 2999, 3001, 3011, 3019, 3023, 3037, 3041, 3049, 3061, 3067, 3079, 3083, 3089,
-        3109, 3119, 3121, 3137, 3163, 3167, 3169, 3181, 3187, 3191, 3203, 3209, 3217, 3221, 3229, 3251, 3253, 3257,
-        3259, 3271, 3299, 3301, 3307, 3313, 3319, 3323, 3329, 3331, 3343, 3347, 3359, 3361, 3371, 3373, 3389, 3391,
-        3407, 3413, 3433, 3449, 3457, 3461, 3463, 3467, 3469, 3491, 3499, 3511, 3517, 3527, 3529, 3533, 3539, 3541,
-        3547, 3557, 3559, 3571, 3581, 3583, 3593, 3607, 3613, 3617, 3623, 3631, 3637, 3643, 3659, 3671, 3673, 3677,
-        3691, 3697, 3701, 3709, 3719, 3727, 3733, 3739, 3761, 3767, 3769, 3779, 3793, 3797, 3803, 3821, 3823, 3833,
-        3847, 3851, 3853, 3863, 3877, 3881, 3889, 3907, 3911, 3917, 3919, 3923, 3929, 3931, 3943, 3947, 3967, 3989,
-        4001, 4003, 4007, 4013, 4019, 4021, 4027, 4049, 4051, 4057, 4073, 4079, 4091, 4093, 4099, 4111, 4127, 4129,
-        4133, 4139, 4153, 4157, 4159, 4177, 4201, 4211, 4217, 4219, 4229, 4231, 4241, 4243, 4253, 4259, 4261, 4271,
-        4273, 4283, 4289, 4297, 4327, 4337, 4339, 4349, 4357, 4363, 4373, 4391, 4397, 4409, 4421, 4423, 4441, 4447,
-        4451, 4457, 4463, 4481, 4483, 4493, 4507, 4513, 4517, 4519, 4523, 4547, 4549, 4561, 4567, 4583, 4591, 4597,
-        4603, 4621, 4637, 4639, 4643, 4649, 4651, 4657, 4663, 4673, 4679, 4691, 4703, 4721, 4723, 4729, 4733, 4751,
-        4759, 4783, 4787, 4789, 4793, 4799, 4801, 4813, 4817, 4831, 4861, 4871, 4877, 4889, 4903, 4909, 4919, 4931,
-        4933, 4937, 4943, 4951, 4957, 4967, 4969, 4973, 4987, 4993, 4999, 5003, 5009, 5011, 5021, 5023, 5039, 5051,
-        5059, 5077, 5081, 5087, 5099, 5101, 5107, 5113, 5119, 5147, 5153, 5167, 5171, 5179, 5189, 5197, 5209, 5227,
-        5231, 5233, 5237, 5261, 5273, 5279, 5281, 5297, 5303, 5309, 5323, 5333, 5347, 5351, 5381, 5387, 5393, 5399,
-        5407, 5413, 5417, 5419, 5431, 5437, 5441, 5443, 5449, 5471, 5477, 5479, 5483, 5501, 5503, 5507, 5519, 5521,
-        5527, 5531, 5557, 5563, 5569, 5573, 5581, 5591, 5623, 5639, 5641, 5647, 5651, 5653, 5657, 5659, 5669, 5683,
-        5689, 5693, 5701, 5711, 5717, 5737, 5741, 5743, 5749, 5779, 5783, 5791, 5801, 5807, 5813, 5821, 5827, 5839,
-        5843, 5849, 5851, 5857, 5861, 5867, 5869, 5879, 5881, 5897, 5903, 5923, 5927, 5939, 5953, 5981, 5987, 6007,
-        6011, 6029, 6037, 6043, 6047, 6053, 6067, 6073, 6079, 6089, 6091, 6101, 6113, 6121, 6131, 6133, 6143, 6151,
-        6163, 6173, 6197, 6199, 6203, 6211, 6217, 6221, 6229, 6247, 6257, 6263, 6269, 6271, 6277, 6287, 6299, 6301,
-        6311, 6317, 6323, 6329, 6337, 6343, 6353, 6359, 6361, 6367, 6373, 6379, 6389, 6397, 6421, 6427, 6449, 6451,
-        6469, 6473, 6481, 6491, 6521, 6529, 6547, 6551, 6553, 6563, 6569, 6571, 6577, 6581, 6599, 6607, 6619, 6637,
-        6653, 6659, 6661, 6673, 6679, 6689, 6691, 6701, 6703, 6709, 6719, 6733, 6737, 6761, 6763, 6779, 6781, 6791,
-        6793, 6803, 6823, 6827, 6829, 6833, 6841, 6857, 6863, 6869, 6871, 6883, 6899, 6907, 6911, 6917, 6947, 6949,
-        6959, 6961, 6967, 6971, 6977, 6983, 6991, 6997, 7001, 7013, 7019, 7027, 7039, 7043, 7057, 7069, 7079, 7103,
-        7109, 7121, 7127, 7129, 7151, 7159, 7177, 7187, 7193, 7207, 7211, 7213, 7219, 7229, 7237, 7243, 7247, 7253,
-        7283, 7297, 7307, 7309, 7321, 7331, 7333, 7349, 7351, 7369, 7393, 7411, 7417, 7433, 7451, 7457, 7459, 7477,
-        7481, 7487, 7489, 7499, 7507, 7517, 7523, 7529, 7537, 7541, 7547, 7549, 7559, 7561, 7573, 7577, 7583, 7589,
-        7591, 7603, 7607, 7621, 7639, 7643, 7649, 7669, 7673, 7681, 7687, 7691, 7699, 7703, 7717, 7723, 7727, 7741,
-        7753, 7757, 7759, 7789, 7793, 7817, 7823, 7829, 7841, 7853, 7867, 7873, 7877, 7879, 7883, 7901, 7907, 7919 };
-
-    // Print primes table by index:
-    // for (size_t i = 0; i < trialDivisionPrimes.size(); ++i) {
-    //     std::cout << i << ": " << trialDivisionPrimes[i] << ", ";
-    // }
-
-    const unsigned cpuCount = std::thread::hardware_concurrency();
-
-    int64_t tdLevel = 7;
-    std::cout << "Wheel factorization level (minimum of " << MIN_RTD_LEVEL << ", max of 7, or -1 for calibration file): ";
-    std::cin >> tdLevel;
-    if ((tdLevel > -1) && (tdLevel < MIN_RTD_LEVEL)) {
-        tdLevel = MIN_RTD_LEVEL;
-    }
-    if (tdLevel > 7) {
-        tdLevel = 7;
-    }
-    if (tdLevel < 0) {
-        std::ifstream settingsFile ("qimcifa_calibration.ssv");
-        std::string header;
-        std::getline(settingsFile, header);
-        double bestCost = DBL_MAX;
-        while (settingsFile.peek() != EOF)
-        {
-            size_t level;
-            BigInteger cardinality;
-            double batchTime, cost;
-            settingsFile >> level;
-            settingsFile >> cardinality;
-            settingsFile >> batchTime;
-            settingsFile >> cost;
-
-            if ((level >= MIN_RTD_LEVEL) && (cost < bestCost)) {
-                tdLevel = level;
-                bestCost = cost;
-            }
-        }
-        settingsFile.close();
-
-        std::cout << "Calibrated reverse trial division level: " << tdLevel << std::endl;
-        std::cout << "Estimated average time to exit: " << (bestCost / (2 * cpuCount)) << " seconds" << std::endl;
+    const std::string backend = getBackendName<BigInteger>();
+    const int64_t level = store.getBestLevel(
+        getQubitCount((BigIntegerInput)toFactor), backend, MIN_RTD_LEVEL, MAX_WHEEL_LEVEL, batchSeconds);
+    if (level < 0) {
+        mismatch = store.describeMismatch(backend);
+        return DEFAULT_RTD_LEVEL;
     }
 
-    size_t nodeCount = 1U;
-    size_t nodeId = 0U;
-#if IS_DISTRIBUTED
-    std::cout << "You can split this work across nodes, without networking!" << std::endl;
-    do {
-        std::cout << "Number of nodes (>=1): ";
-        std::cin >> nodeCount;
-        if (!nodeCount) {
-            std::cout << "Invalid node count choice!" << std::endl;
-        }
-    } while (!nodeCount);
-    if (nodeCount > 1U) {
-        do {
-            std::cout << "Which node is this? (0-" << (nodeCount - 1U) << "): ";
-            std::cin >> nodeId;
-            if (nodeId >= nodeCount) {
-                std::cout << "Invalid node ID choice!" << std::endl;
-            }
-        } while (nodeId >= nodeCount);
-    }
+    return level;
+}
+
+// Command line options
+struct RunOptions {
+    // Time budget, in seconds, (or 0 for none)
+    double timeout;
+    bool isCheckpointing;
+    // (Empty for the default, per node)
+    std::string checkpointPath;
+    double checkpointInterval;
+    // Coordinate with other nodes through leases in this directory, (or split statically, if empty).
+    std::string sharedDir;
+    double leaseTtl;
+    // Batches per lease, (or 0 to choose automatically)
+    uint64_t leaseBatches;
+    // Seconds between progress summaries, (or 0 for none)
+    double statsInterval;
+    // Machine-readable stats, rewritten at the same interval, (or empty for none)
+    std::string statsFile;
+    // Sieve semiprime candidates with the primes up to this bound, (or 0 for none)
+    size_t sieveBound;
+    // Bounds on the smaller factor, (or 0 for none: from 1, or half the width for a semiprime, up to the root)
+    BigIntegerInput lowerBound;
+    BigIntegerInput upperBound;
+    // Search by Fermat's method alone, instead of trial division
+    bool isFermat;
+    // Seconds of Fermat's method to try first, (or 0 for none)
+    double fermatPrepass;
+    // Seconds of Pollard's rho to try first, (or 0 for none)
+    double rhoPrepass;
+    // Search by the self-initialising quadratic sieve, instead of trial division
+    bool isSiqs;
+    // Memory for batch GCD tree levels, in MiB, before the rest go to files in "gcdSpillDir"
+    size_t gcdMemory;
+    std::string gcdSpillDir;
+    // Factor completely, (into primes,) rather than stopping at the first split
+    bool isFactorize;
+    // Strip the prime factors up to this bound by trial division, first, when factoring completely
+    size_t stripBound;
+#if IS_RANDOM
+    uint64_t seed;
 #endif
 
-    // Starting clock right after user input is finished
-    auto iterClock = std::chrono::high_resolution_clock::now();
+    RunOptions()
+        : timeout(0.0)
+        , isCheckpointing(true)
+        , checkpointInterval(DEFAULT_CHECKPOINT_INTERVAL)
+        , leaseTtl(DEFAULT_LEASE_TTL)
+        , leaseBatches(0U)
+        , statsInterval(DEFAULT_STATS_INTERVAL)
+        , sieveBound(DEFAULT_SIEVE_BOUND)
+        , lowerBound(0U)
+        , upperBound(0U)
+        , isFermat(false)
+        , fermatPrepass(0.0)
+#if IS_RSA_SEMIPRIME
+        , rhoPrepass(0.0)
+#else
+        , rhoPrepass(DEFAULT_RHO_PREPASS)
+#endif
+        , isSiqs(false)
+        , gcdMemory(DEFAULT_GCD_MEMORY)
+        , gcdSpillDir(".")
+        , isFactorize(false)
+        , stripBound(DEFAULT_STRIP_BOUND)
+#if IS_RANDOM
+        , seed(0U)
+#endif
+    {
+        // Intentionally left blank.
+    }
+};
 
-    const BigInteger fullMaxBase = sqrt<BigInteger>(toFactor);
+// Handle the trivial cases, (perfect squares and multiples of the wheel primes themselves,) and
+// otherwise set up this node's slice of the batch range. Returns false, with the scheduler's result
+// set, if there's nothing left to search.
+template <typename BigInteger>
+bool setupSearch(const BigInteger& toFactor, const int64_t& tdLevel, const size_t& nodeCount, const size_t& nodeId,
+    const BigIntegerInput& lowerBound, const BigIntegerInput& upperBound, const uint64_t& workerCount,
+    BatchScheduler& scheduler, BigInteger& offset)
+{
+    const BigInteger fullMaxBase = isqrt<BigInteger>(toFactor);
     if (fullMaxBase * fullMaxBase == toFactor) {
-        std::cout << "Number to factor is a perfect square: " << fullMaxBase << " * " << fullMaxBase << " = " << toFactor;
-        return 0;
+        std::stringstream ss;
+        ss << "Number to factor is a perfect square: " << fullMaxBase << " * " << fullMaxBase << " = " << toFactor;
+        scheduler.setResult(ss.str(), (BigIntegerInput)fullMaxBase);
+        return false;
     }
 
     for (int64_t primeIndex = 0; primeIndex < tdLevel; ++primeIndex) {
-        const unsigned currentPrime = trialDivisionPrimes[primeIndex];
+        const size_t currentPrime = WHEEL_TABLE_PRIMES[primeIndex];
         if ((toFactor % currentPrime) == 0) {
-            std::cout << "Factors: " << currentPrime << " * " << (toFactor / currentPrime) << " = " << toFactor
-                      << std::endl;
-            return 0;
+            std::stringstream ss;
+            ss << "Factors: " << currentPrime << " * " << (toFactor / currentPrime) << " = " << toFactor;
+            scheduler.setResult(ss.str(), (BigIntegerInput)currentPrime);
+            return false;
         }
-        ++primeIndex;
     }
 
 #if IS_SQUARES_CONGRUENCE_CHECK
-    const BigInteger offset = (fullMaxBase / BIGGEST_WHEEL) * BIGGEST_WHEEL + 2U;
-    const BigInteger fullRange = backward(1U + toFactor - offset);
+    // (The congruence of squares search runs from the square root up, so factor bounds don't apply.)
+    (void)lowerBound;
+    (void)upperBound;
+    offset = (fullMaxBase / BIGGEST_WHEEL) * BIGGEST_WHEEL + 2U;
+    const BigInteger lowBatch = 0U;
+    const BigInteger batchRange = (backward(1U + toFactor - offset) + BIGGEST_WHEEL - 1U) / BIGGEST_WHEEL;
 #else
-    const BigInteger offset = 1U;
-    const BigInteger fullRange = backward(fullMaxBase);
+    offset = 1U;
+    BigInteger lowBatch, highBatch;
+    getSearchBatches(toFactor, lowerBound, upperBound, lowBatch, highBatch);
+    const BigInteger batchRange = highBatch - lowBatch;
+    if (batchRange == 0U) {
+        std::stringstream ss;
+        ss << "Nothing to search: the factor bounds exclude every candidate for " << toFactor;
+        scheduler.setResult(ss.str());
+        return false;
+    }
 #endif
-
-    std::vector<boost::dynamic_bitset<uint64_t>> inc_seqs = wheel_gen(std::vector<BigInteger>(trialDivisionPrimes.begin(), trialDivisionPrimes.begin() + tdLevel), toFactor);
-    inc_seqs.erase(inc_seqs.begin(), inc_seqs.begin() + 2U);
+    scheduler.lowBatch = (BigIntegerInput)lowBatch;
 
 #if 0
 #if BIG_INTEGER_BITS > 64 && !USE_BOOST && !USE_GMP
@@ -224,117 +222,1219 @@ int mainBody(const BigInteger& toFactor)
 
     BigInteger radius = 1U;
     for (int64_t i = 0U; i < tdLevel; ++i) {
-        radius *= trialDivisionPrimes[i];
+        radius *= WHEEL_TABLE_PRIMES[i];
     }
     radius = (BigInteger)pow((uint64_t)radius, exp / 32.0);
 #endif
 
-    const BigInteger nodeRange = (((fullRange + nodeCount - 1U) / nodeCount) + BIGGEST_WHEEL - 1U) / BIGGEST_WHEEL;
-    batchNumber = nodeId * nodeRange;
-    batchBound = (nodeId + 1) * nodeRange;
-    batchCount = nodeCount * nodeRange;
+#if IS_RANDOM
+    // Every node shares one keyed order over all batches, (however many,) and takes its own slice of
+    // claim indices.
+    std::stringstream number;
+    number << toFactor;
+    scheduler.setOrder((BigIntegerInput)batchRange, hashKey(number.str(), scheduler.seed));
+    const uint64_t batchCount = scheduler.order.size;
+    const uint64_t nodeBatches = (batchCount + nodeCount - 1U) / nodeCount;
+    const uint64_t nodeFirst = nodeId * nodeBatches;
+    scheduler.orderFirst = nodeFirst;
+    scheduler.setRange(0U,
+        (BigIntegerInput)((nodeFirst < batchCount) ? std::min(nodeBatches, batchCount - nodeFirst) : 0U), workerCount);
+#else
+    const BigInteger nodeRange = (batchRange + nodeCount - 1U) / nodeCount;
+#if IS_SQUARES_CONGRUENCE_CHECK
+    // Each node counts up through its own slice of batches...
+    scheduler.setRange((BigIntegerInput)(nodeId * nodeRange), (BigIntegerInput)nodeRange, workerCount);
+#else
+    // ...or down, from the top of its slice, (nearest the square root,) for exact factors.
+    scheduler.setRange((BigIntegerInput)(lowBatch + (nodeCount - nodeId) * nodeRange - 1U),
+        (BigIntegerInput)nodeRange, workerCount);
+#endif
+#endif
+
+    return true;
+}
+
+// What a search that runs out of candidates covered, (for its report,) and, if the balanced semiprime
+// assumption set its lower bound, how to search below that.
+template <typename BigInteger>
+void describeExhausted(const BigInteger& toFactor, const BigIntegerInput& lowerBound,
+    const BigIntegerInput& upperBound, std::string& message, std::string& hint)
+{
+#if IS_SQUARES_CONGRUENCE_CHECK
+    (void)toFactor;
+    (void)lowerBound;
+    (void)upperBound;
+    message = "no factor found";
+    hint.clear();
+#else
+    BigInteger low, high;
+    const bool isAssumed = getSearchBounds(toFactor, lowerBound, upperBound, low, high);
+    std::stringstream ss;
+    ss << "no factor found in [" << low << ", " << high << "]";
+    message = ss.str();
+    hint = isAssumed ? "(The lower bound assumes factors of equal bit width: rerun with --lower-bound <factor> or "
+                       "--factor-bits <bits> to search below it.)"
+                     : "";
+#endif
+}
+
+template <typename BigInteger> struct RhoBody {
+    static int run(const BigInteger& toFactor, const size_t& nodeCount, const size_t& nodeId,
+        const unsigned& workerCount, BatchScheduler& scheduler)
+    {
+        runPollardRho(toFactor, nodeCount, nodeId, workerCount, scheduler);
+
+        return 0;
+    }
+};
+
+// Run "Body" at (at least) "width" bits, for engines that hold products of residues modulo N. Returns
+// false, (without running it,) if this build has no integer that wide.
+template <template <typename> class Body, typename... Args>
+bool dispatchByMinWidth(const uint32_t& width, const BigIntegerInput& toFactor, Args&... args)
+{
+#if !(USE_GMP || USE_BOOST)
+    if (width > BIG_INTEGER_BITS) {
+        return false;
+    }
+#elif USE_BOOST
+    if (width >= 8192U) {
+        return false;
+    }
+#endif
+    dispatchByWidth<Body>(width, toFactor, args...);
+
+    return true;
+}
+
+// Pollard's rho squares residues, so it runs at twice the width of the number to factor.
+inline bool runRhoSearch(const BigIntegerInput& toFactor, const size_t& nodeCount, const size_t& nodeId,
+    const unsigned& workerCount, BatchScheduler& scheduler)
+{
+    return dispatchByMinWidth<RhoBody>(
+        2U * getQubitCount(toFactor), toFactor, nodeCount, nodeId, workerCount, scheduler);
+}
+
+template <typename BigInteger> struct SiqsBody {
+    static int run(const BigInteger& toFactor, const size_t& nodeId, const unsigned& workerCount,
+        BatchScheduler& scheduler)
+    {
+        SiqsEngine<BigInteger> engine(toFactor);
+        if (!engine.prepare(scheduler)) {
+            return 0;
+        }
+        if (!scheduler.isQuiet) {
+            std::cout << "SIQS: multiplier " << engine.multiplier << ", " << (engine.factorBase.size() - 1U)
+                      << " factor base primes (up to " << engine.factorBase.back().prime << "), sieve interval "
+                      << (2U * engine.parameters.halfInterval) << ", " << engine.aPrimeCount
+                      << " primes per polynomial coefficient" << std::endl;
+        }
+        SiqsRelationStore<BigInteger> store(engine.factorBase.size() + SIQS_EXTRA_RELATIONS);
+        for (size_t round = 1U; collectSiqsRelations(engine, nodeId, workerCount, store, scheduler); ++round) {
+            if (!scheduler.isQuiet) {
+                std::cout << "SIQS: collected " << store.relations.size() << " relations (" << store.fullCount
+                          << " full, " << store.pairCount << " from partial pairs) from " << store.polynomialCount
+                          << " polynomials, in " << scheduler.elapsed() << " seconds" << std::endl;
+            }
+            if (findSiqsFactor(engine, store, workerCount, scheduler) || scheduler.isStopped()) {
+                break;
+            }
+            if (round == SIQS_MAX_ROUNDS) {
+                if (!scheduler.isQuiet) {
+                    std::cout << "SIQS: no dependency split N, in " << round
+                              << " rounds, (so it's most likely a prime, or a prime power)." << std::endl;
+                }
+                break;
+            }
+            if (!scheduler.isQuiet) {
+                std::cout << "(No dependency split N, so collecting " << SIQS_EXTRA_RELATIONS << " more relations.)"
+                          << std::endl;
+            }
+            store.extend(SIQS_EXTRA_RELATIONS);
+        }
+
+        return 0;
+    }
+};
+
+// The sieve holds y^2 for "y" up to about sqrt(2kN), (with a multiplier "k" below 2^7,) and products
+// of two residues modulo N. Returns false, (without searching,) if this build has no integer that wide.
+inline bool runSiqsSearch(
+    const BigIntegerInput& toFactor, const size_t& nodeId, const unsigned& workerCount, BatchScheduler& scheduler)
+{
+    return dispatchByMinWidth<SiqsBody>(2U * getQubitCount(toFactor) + 16U, toFactor, nodeId, workerCount, scheduler);
+}
+
+template <typename BigInteger> struct PrimeTestBody {
+    static int run(const BigInteger& n, bool& isPrime)
+    {
+        isPrime = isProbablePrime(n);
+
+        return 0;
+    }
+};
+
+// Miller-Rabin squares residues, so it runs at twice the width of "n," (or unbounded, past the widest
+// fixed width). Returns false, (without testing,) if this build has no integer that wide.
+inline bool testPrime(const BigIntegerInput& n, bool& isPrime)
+{
+    if (dispatchByMinWidth<PrimeTestBody>(2U * getQubitCount(n), n, isPrime)) {
+        return true;
+    }
+#if USE_GMP || USE_BOOST
+    isPrime = isProbablePrime((CorpusInteger)n);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Run "fn" every "interval" seconds, on its own thread, until destroyed.
+struct PeriodicTask {
+    std::mutex taskMutex;
+    std::condition_variable taskCv;
+    bool isDone;
+    std::thread thread;
+
+    PeriodicTask(const double& interval, const std::function<void()>& fn)
+        : isDone(false)
+        , thread([this, interval, fn]() {
+            std::unique_lock<std::mutex> lock(taskMutex);
+            while (!taskCv.wait_for(lock, std::chrono::duration<double>(interval), [this] { return isDone; })) {
+                lock.unlock();
+                fn();
+                lock.lock();
+            }
+        })
+    {
+        // Intentionally left blank.
+    }
+
+    ~PeriodicTask()
+    {
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            isDone = true;
+        }
+        taskCv.notify_all();
+        thread.join();
+    }
+};
+
+template <typename BigInteger> struct MainBody {
+    static int run(const BigInteger& toFactor, const RunOptions& options)
+    {
+        const unsigned cpuCount = std::thread::hardware_concurrency();
+
+        int64_t tdLevel = DEFAULT_RTD_LEVEL;
+        std::cout << "Wheel factorization level (minimum of " << MIN_RTD_LEVEL
+                  << ", max of " << MAX_WHEEL_LEVEL << ", or -1 for calibration file): ";
+        std::cin >> tdLevel;
+        if ((tdLevel > -1) && (tdLevel < MIN_RTD_LEVEL)) {
+            tdLevel = MIN_RTD_LEVEL;
+        }
+        if (tdLevel > (int64_t)MAX_WHEEL_LEVEL) {
+            tdLevel = MAX_WHEEL_LEVEL;
+        }
+        double batchSeconds = -1.0;
+        if (tdLevel < 0) {
+            CalibrationStore store(getSearchOptions(options.sieveBound));
+            store.load();
+            std::string mismatch;
+            tdLevel = getCalibratedLevel(toFactor, store, batchSeconds, mismatch);
+            if (batchSeconds < 0.0) {
+                std::cout << "No matching calibration (" << mismatch << "), so using level " << tdLevel << "."
+                          << std::endl;
+            } else {
+                std::cout << "Calibrated reverse trial division level: " << tdLevel << std::endl;
+            }
+        }
+
+        size_t nodeCount = 1U;
+        size_t nodeId = 0U;
+#if IS_DISTRIBUTED
+        // (With a shared directory, nodes split the work dynamically, instead.)
+        if (options.sharedDir.empty()) {
+            std::cout << "You can split this work across nodes, without networking!" << std::endl;
+            do {
+                std::cout << "Number of nodes (>=1): ";
+                std::cin >> nodeCount;
+                if (!nodeCount) {
+                    std::cout << "Invalid node count choice!" << std::endl;
+                }
+            } while (!nodeCount);
+            if (nodeCount > 1U) {
+                do {
+                    std::cout << "Which node is this? (0-" << (nodeCount - 1U) << "): ";
+                    std::cin >> nodeId;
+                    if (nodeId >= nodeCount) {
+                        std::cout << "Invalid node ID choice!" << std::endl;
+                    }
+                } while (nodeId >= nodeCount);
+            }
+        }
+#endif
+
+        std::vector<size_t> workerCpus;
+#if IS_TOPOLOGY_AWARE
+        int placement = PLACE_DEFAULT;
+        do {
+            std::cout << "Worker placement (0: leave to OS, 1: pin one per physical core, 2: pin one per hardware "
+                         "thread): ";
+            std::cin >> placement;
+            if ((placement < PLACE_DEFAULT) || (placement > PLACE_PER_THREAD)) {
+                std::cout << "Invalid worker placement choice!" << std::endl;
+            }
+        } while ((placement < PLACE_DEFAULT) || (placement > PLACE_PER_THREAD));
+        workerCpus = getWorkerCpus((WorkerPlacement)placement);
+#endif
+        const unsigned workerCount = workerCpus.empty() ? cpuCount : (unsigned)workerCpus.size();
+
+        // Starting clock right after user input is finished
+        BatchScheduler scheduler;
+        scheduler.budget = std::chrono::nanoseconds((int64_t)(options.timeout * 1e9));
+#if IS_RANDOM
+        scheduler.seed = options.seed;
+        std::string order = std::to_string(options.seed);
+#else
+        std::string order = "sequential";
+#endif
+
+        BigInteger offset = 0U;
+        if (!setupSearch(toFactor, tdLevel, nodeCount, nodeId, options.lowerBound, options.upperBound, workerCount,
+                scheduler, offset)) {
+            std::cout << scheduler.result << std::endl;
+            return 0;
+        }
+        // (A checkpoint or lease from another search interval must never match this one.)
+        if (scheduler.lowBatch != 0U) {
+            std::stringstream interval;
+            interval << order << "@" << scheduler.lowBatch;
+            order = interval.str();
+        }
+        // (Each pre-pass has its own clock, but its time still counts against the overall budget.)
+        if (options.rhoPrepass > 0.0) {
+            BatchScheduler rho;
+            rho.budget = std::chrono::nanoseconds((int64_t)(options.rhoPrepass * 1e9));
+            if (!runRhoSearch((BigIntegerInput)toFactor, nodeCount, nodeId, workerCount, rho)) {
+                std::cout << "(Skipping the Pollard rho pre-pass: this build's integers are too narrow for it.)"
+                          << std::endl;
+            } else if (!rho.result.empty()) {
+                return 0;
+            } else if (rho.isInterrupted) {
+                std::cout << "Interrupted (after " << rho.elapsed() << " seconds)" << std::endl;
+                return 0;
+            } else {
+                std::cout << "Pollard rho pre-pass found no factor (after " << rho.elapsed() << " seconds)"
+                          << std::endl;
+            }
+        }
+        if (options.isFermat || (options.fermatPrepass > 0.0)) {
+            BatchScheduler fermat;
+            fermat.budget = std::chrono::nanoseconds(
+                (int64_t)((options.isFermat ? options.timeout : options.fermatPrepass) * 1e9));
+            runFermatSearch(toFactor, nodeCount, nodeId, workerCount, fermat);
+            if (!fermat.result.empty()) {
+                return 0;
+            }
+            if (fermat.isInterrupted) {
+                std::cout << "Interrupted (after " << fermat.elapsed() << " seconds)" << std::endl;
+                return 0;
+            }
+            if (options.isFermat) {
+                if (fermat.isTimedOut) {
+                    std::cout << "Time budget exhausted (after " << fermat.elapsed() << " seconds)" << std::endl;
+                } else {
+                    std::cout << "Fermat's method found no factor (after " << fermat.elapsed() << " seconds)"
+                              << std::endl;
+                }
+                return 0;
+            }
+            std::cout << "Fermat pre-pass found no factor (after " << fermat.elapsed() << " seconds)" << std::endl;
+        }
+        if (options.isSiqs) {
+            BatchScheduler siqs;
+            siqs.budget = std::chrono::nanoseconds((int64_t)(options.timeout * 1e9));
+            if (getQubitCount((BigIntegerInput)toFactor) < SIQS_MIN_BITS) {
+                std::cout << "(Skipping the quadratic sieve: it needs at least " << SIQS_MIN_BITS << " bits.)"
+                          << std::endl;
+            } else if (!runSiqsSearch((BigIntegerInput)toFactor, nodeId, workerCount, siqs)) {
+                std::cout << "(Skipping the quadratic sieve: this build's integers are too narrow for it.)"
+                          << std::endl;
+            } else {
+                if (siqs.isInterrupted) {
+                    std::cout << "Interrupted (after " << siqs.elapsed() << " seconds)" << std::endl;
+                } else if (siqs.isTimedOut) {
+                    std::cout << "Time budget exhausted (after " << siqs.elapsed() << " seconds)" << std::endl;
+                }
+                return 0;
+            }
+        }
+        if (options.sieveBound) {
+            scheduler.sievePrimes = &getSievePrimes(tdLevel, options.sieveBound);
+        }
+        if (batchSeconds > 0.0) {
+            std::cout << "Estimated average time to exit: " << (scheduler.total * batchSeconds / (2 * workerCount))
+                      << " seconds" << std::endl;
+        }
+
+        std::stringstream number;
+        number << toFactor;
+
+        std::unique_ptr<SharedLeaseLedger> leases;
+        if (!options.sharedDir.empty()) {
+            leases.reset(new SharedLeaseLedger(options.sharedDir, options.leaseTtl));
+            std::stringstream description;
+            description << "number " << number.str() << std::endl
+                        << "order " << order << std::endl
+                        << "level " << tdLevel << std::endl
+                        << "total " << scheduler.total << std::endl;
+            std::string error;
+            if (!leases->join(description.str(), scheduler.total, options.leaseBatches, error)) {
+                std::cout << error << "!" << std::endl;
+                return 1;
+            }
+        }
+
+        // (The shared directory's "done" markers already serve as the checkpoint, with leases.)
+        std::unique_ptr<ProgressLedger> ledger;
+        if (options.isCheckpointing && !leases) {
+            const std::string path = options.checkpointPath.empty()
+                ? getDefaultCheckpointPath(number.str(), order, tdLevel, nodeCount, nodeId)
+                : options.checkpointPath;
+            ledger.reset(new ProgressLedger(
+                path, number.str(), order, tdLevel, nodeCount, nodeId, scheduler.total, options.checkpointInterval));
+            if (ledger->load()) {
+                std::cout << "Resuming from checkpoint " << path << ": " << ledger->completedCount() << " of "
+                          << scheduler.total << " batches already searched" << std::endl;
+            } else if (ledger->isMismatched) {
+                std::cout << "Checkpoint " << path << " is not for this search (number, order, level, and nodes), "
+                          << "so it won't be overwritten! Pass --checkpoint <file> to save elsewhere, or "
+                          << "--no-checkpoint." << std::endl;
+                return 1;
+            }
+            scheduler.attach(ledger.get());
+        }
+
+        std::unique_ptr<SearchStats> stats;
+        std::unique_ptr<PeriodicTask> reporter;
+        if ((options.statsInterval > 0.0) || !options.statsFile.empty()) {
+            stats.reset(new SearchStats(workerCount, ledger ? ledger->fullTotal : scheduler.total,
+                ledger ? ledger->completedCount() : 0U));
+            scheduler.stats = stats.get();
+            const double interval = (options.statsInterval > 0.0) ? options.statsInterval : DEFAULT_STATS_INTERVAL;
+            reporter.reset(new PeriodicTask(interval, [&stats, &options]() {
+                if (options.statsInterval > 0.0) {
+                    std::cout << stats->summary() << std::endl;
+                }
+                if (!options.statsFile.empty()) {
+                    stats->writeFile(options.statsFile);
+                }
+            }));
+        }
+
+        // Build (or reuse) the shared wheel table before any worker starts.
+        const std::vector<unsigned char>& wheelGaps = getWheelGaps(tdLevel);
+
+        const auto workerFn = [toFactor, tdLevel, &wheelGaps, &offset, &scheduler](
+                                  const std::vector<size_t>& cpus, const size_t& id) {
+            if (cpus.empty()) {
+                // Each worker only owns a cursor into the shared table.
+                WheelIterator wheel(wheelGaps, tdLevel);
+                getSmoothNumbers(toFactor, wheel, offset, scheduler);
+                return;
+            }
+
+            pinThisThread(cpus[id]);
+            // Copying after pinning places this worker's table in its own NUMA node's memory.
+            const std::vector<unsigned char> localGaps(wheelGaps);
+            WheelIterator wheel(localGaps, tdLevel);
+            getSmoothNumbers(toFactor, wheel, offset, scheduler);
+        };
+
+        const auto runWorkers = [&workerFn, &workerCpus, &workerCount]() {
+            std::vector<std::future<void>> futures;
+            futures.reserve(workerCount);
+
+            for (unsigned cpu = 0U; cpu < workerCount; ++cpu) {
+                futures.push_back(std::async(std::launch::async, workerFn, std::cref(workerCpus), (size_t)cpu));
+            }
+
+            for (unsigned cpu = 0U; cpu < workerCount; ++cpu) {
+                futures[cpu].get();
+            }
+        };
+
+        if (!leases) {
+            runWorkers();
+        } else {
+            // A heartbeat renews our lease, and stops our workers if another node succeeds. It holds
+            // "leaseMutex" throughout, as we do while we swap in the next slice, or give up the last one,
+            // so it never renews a finished chunk, misses a new one, or stops a slice that we then reset.
+            const double poll = std::min(1.0, options.leaseTtl / 3);
+            std::mutex leaseMutex;
+            bool isLeased = false;
+            uint64_t chunk = 0U;
+            bool isFoundElsewhere = false;
+            auto lastRenewal = std::chrono::high_resolution_clock::now();
+            std::unique_ptr<PeriodicTask> heartbeat(new PeriodicTask(poll, [&]() {
+                std::lock_guard<std::mutex> lock(leaseMutex);
+                if (leases->isFound()) {
+                    std::lock_guard<std::mutex> resultLock(scheduler.resultMutex);
+                    if (scheduler.result.empty()) {
+                        isFoundElsewhere = true;
+                        scheduler.finish();
+                    }
+                }
+                const auto now = std::chrono::high_resolution_clock::now();
+                const double sinceRenewal = std::chrono::duration<double>(now - lastRenewal).count();
+                if (isLeased && (sinceRenewal >= (options.leaseTtl / 3))) {
+                    leases->renew(chunk);
+                    lastRenewal = now;
+                }
+            }));
+
+            const BigIntegerInput rangeFirst = scheduler.first;
+            const uint64_t rangeTotal = scheduler.total;
+            uint64_t c;
+            while (leases->acquire(c, getStopRequest(), poll)) {
+                {
+                    std::lock_guard<std::mutex> lock(leaseMutex);
+                    if (isFoundElsewhere) {
+                        leases->release(c);
+                        break;
+                    }
+                    const uint64_t start = c * leases->chunkSize;
+                    scheduler.setSlice(rangeFirst, start, std::min(leases->chunkSize, rangeTotal - start));
+                    chunk = c;
+                    isLeased = true;
+                    // (The lease file was just created.)
+                    lastRenewal = std::chrono::high_resolution_clock::now();
+                }
+                runWorkers();
+                std::lock_guard<std::mutex> lock(leaseMutex);
+                isLeased = false;
+                if (scheduler.isFinished) {
+                    // (Successful, or stopped early, so this chunk isn't done.)
+                    leases->release(c);
+                    break;
+                }
+                leases->complete(c);
+            }
+
+            heartbeat.reset();
+
+            if (!scheduler.result.empty()) {
+                leases->markFound(scheduler.result);
+            } else if (leases->isFound()) {
+                std::cout << "Found by another node: " << leases->readFound() << std::endl;
+            }
+        }
+
+        reporter.reset();
+        if (stats && !options.statsFile.empty()) {
+            stats->writeFile(options.statsFile);
+        }
+
+        if (scheduler.result.empty()) {
+            if (scheduler.isInterrupted) {
+                std::cout << "Interrupted (after " << scheduler.elapsed() << " seconds)" << std::endl;
+            } else if (scheduler.isTimedOut) {
+                std::cout << "Time budget exhausted (after " << scheduler.elapsed() << " seconds)" << std::endl;
+            } else if (!leases || !leases->isFound()) {
+                std::string message, hint;
+                describeExhausted(toFactor, options.lowerBound, options.upperBound, message, hint);
+                std::cout << toFactor << ": " << ((nodeCount > 1U) ? "this node's share: " : "") << message
+                          << " (after " << scheduler.elapsed() << " seconds)" << std::endl;
+                if (!hint.empty()) {
+                    std::cout << hint << std::endl;
+                }
+            }
+        }
+
+        if (ledger) {
+            if (scheduler.result.empty() && (scheduler.isInterrupted || scheduler.isTimedOut)) {
+                if (ledger->save()) {
+                    std::cout << "Progress saved to " << ledger->path << std::endl;
+                } else {
+                    std::cout << "Could not save progress to " << ledger->path << "!" << std::endl;
+                }
+            } else {
+                ledger->remove();
+            }
+        }
+
+        return 0;
+    }
+};
+
+// An engine for a batch job to run before its batch search, (or instead of it,) on the runner's workers
+struct JobStage {
+    // Run on some number of threads, until "clock" stops it, and return false if it doesn't apply.
+    std::function<bool(const unsigned&, BatchScheduler&)> run;
+    // Time budget, (or 0 for the rest of the job's own)
+    double seconds;
+    // Nothing is left to search after this stage, if it runs.
+    bool isFinal;
+    // Estimated thread-seconds, (in the same units as the job's cost,) to rank jobs
+    double cost;
+};
+
+// One line of batch input: a number to factor, with an optional wheel level and time budget
+struct FactoringJob {
+    // (The job's line number in its input, which tags its output)
+    size_t id;
+    BigIntegerInput toFactor;
+    int64_t level;
+    // (Seconds, or 0 for none)
+    double budget;
+    // Estimated batch count times calibrated batch time, to rank jobs
+    double cost;
+    // What the search covered, if it finds nothing, (see describeExhausted())
+    std::string exhausted;
+    std::string exhaustedHint;
+    BatchScheduler scheduler;
+    // Search up to some number of batch claims, with the worker's own wheel cursor
+    std::function<void(WheelIterator&, const uint64_t&)> work;
+    // Engines to run first, in order, (one at a time,) and the next of them
+    std::vector<JobStage> stages;
+    size_t stageIndex;
+    bool isStageRunning;
+    size_t activeWorkers;
+    bool isStarted;
+    bool isDone;
+
+    FactoringJob()
+        : id(0U)
+        , toFactor(0U)
+        , level(-1)
+        , budget(0.0)
+        , cost(0.0)
+        , exhausted("no factor found")
+        , stageIndex(0U)
+        , isStageRunning(false)
+        , activeWorkers(0U)
+        , isStarted(false)
+        , isDone(false)
+    {
+        // Intentionally left blank.
+    }
+
+    bool isInStages() const { return stageIndex < stages.size(); }
+
+    double remainingCost() const
+    {
+        double stageCost = 0.0;
+        for (size_t i = stageIndex; i < stages.size(); ++i) {
+            stageCost += stages[i].cost;
+        }
+        const uint64_t claimed = scheduler.claimed.load(std::memory_order_relaxed);
+        return stageCost + ((claimed >= scheduler.total) ? 0.0 : (cost * (scheduler.total - claimed)) / scheduler.total);
+    }
+
+    void report() const
+    {
+        std::cout << "[" << id << "] ";
+        if (!scheduler.result.empty()) {
+            std::cout << scheduler.result << " (level " << level << ", " << scheduler.resultSeconds << " seconds)";
+        } else if (scheduler.isInterrupted) {
+            std::cout << toFactor << ": interrupted (level " << level << ", " << scheduler.elapsed() << " seconds)";
+        } else if (scheduler.isTimedOut) {
+            std::cout << toFactor << ": time budget exhausted (level " << level << ", " << scheduler.elapsed()
+                      << " seconds)";
+        } else {
+            std::cout << toFactor << ": " << exhausted << " (level " << level << ", " << scheduler.elapsed()
+                      << " seconds)";
+            if (!exhaustedHint.empty()) {
+                std::cout << " " << exhaustedHint;
+            }
+        }
+        std::cout << std::endl;
+    }
+};
+
+template <typename BigInteger> struct PrepareJob {
+    static int run(const BigInteger& toFactor, FactoringJob& job, const uint64_t& workerCount,
+        const CalibrationStore& store, const RunOptions& options)
+    {
+        BatchScheduler& scheduler = job.scheduler;
+        scheduler.isQuiet = true;
+        scheduler.budget = std::chrono::nanoseconds((int64_t)(job.budget * 1e9));
+
+        std::string mismatch;
+        double batchSeconds = -1.0;
+        const int64_t calibratedLevel = getCalibratedLevel(toFactor, store, batchSeconds, mismatch);
+        if (job.level < 0) {
+            job.level = calibratedLevel;
+            if (batchSeconds < 0.0) {
+                std::cout << "[" << job.id << "] No matching calibration (" << mismatch << "), so using level "
+                          << job.level << "." << std::endl;
+            }
+        } else {
+            batchSeconds = store.getBatchSeconds(
+                getQubitCount((BigIntegerInput)toFactor), getBackendName<BigInteger>(), job.level);
+        }
+        // Build (or reuse) the wheel table, before any worker needs it.
+        getWheelGaps(job.level);
+
+        BigInteger offset = 0U;
+        if (!setupSearch(
+                toFactor, job.level, 1U, 0U, options.lowerBound, options.upperBound, workerCount, scheduler, offset)) {
+            return 0;
+        }
+        describeExhausted(toFactor, options.lowerBound, options.upperBound, job.exhausted, job.exhaustedHint);
+        // (The runner runs these, within the job's own budget, so they queue like any other work.)
+        const BigIntegerInput n = (BigIntegerInput)toFactor;
+        const auto getStageCost = [&job, &workerCount](const double& seconds) {
+            const double s = ((seconds > 0.0) && ((job.budget <= 0.0) || (seconds < job.budget))) ? seconds : job.budget;
+            return (s > 0.0) ? (s * workerCount) : (DBL_MAX / 4);
+        };
+        // (Pollard's rho can never split a prime, so it would only use up the whole pre-pass.)
+        bool isPrime = false;
+        if ((options.rhoPrepass > 0.0) && !(testPrime(n, isPrime) && isPrime)) {
+            job.stages.push_back(JobStage{ [n](const unsigned& threads, BatchScheduler& clock) {
+                                              return runRhoSearch(n, 1U, 0U, threads, clock);
+                                          },
+                options.rhoPrepass, false, getStageCost(options.rhoPrepass) });
+        }
+        if (options.isFermat || (options.fermatPrepass > 0.0)) {
+            const double seconds = options.isFermat ? 0.0 : options.fermatPrepass;
+            job.stages.push_back(JobStage{ [toFactor](const unsigned& threads, BatchScheduler& clock) {
+                                              runFermatSearch(toFactor, 1U, 0U, threads, clock);
+                                              return true;
+                                          },
+                seconds, options.isFermat, getStageCost(seconds) });
+        }
+        if (options.isSiqs && !(getQubitCount(n) < SIQS_MIN_BITS)) {
+            // (If it runs, there's nothing else to search.)
+            job.stages.push_back(JobStage{ [n](const unsigned& threads, BatchScheduler& clock) {
+                                              return runSiqsSearch(n, 0U, threads, clock);
+                                          },
+                0.0, true, getStageCost(0.0) });
+        }
+        if (options.sieveBound) {
+            scheduler.sievePrimes = &getSievePrimes(job.level, options.sieveBound);
+        }
+        // Without calibration, every batch costs the same, and we rank by size alone.
+        job.cost = scheduler.total * ((batchSeconds > 0.0) ? batchSeconds : 1.0);
+        job.work = [toFactor, offset, &scheduler](WheelIterator& wheel, const uint64_t& maxClaims) {
+            getSmoothNumbers(toFactor, wheel, offset, scheduler, maxClaims);
+        };
+
+        return 0;
+    }
+};
+
+// Free workers always join the job with the least estimated work left, (that can still use another
+// worker,) one batch claim at a time. Small jobs then never wait behind big ones, and big jobs soak
+// up every worker that the small jobs can't use. Workers and wheel tables live for the whole run.
+// A job's engine stages run first, one at a time, each on its share of the free workers, (and the
+// workers that it takes over wait until it's done).
+struct JobRunner {
+    std::vector<std::unique_ptr<FactoringJob>>& jobs;
+    const unsigned workerCount;
+    size_t jobsLeft;
+    // Threads in use, (by batch claims and engine stages)
+    unsigned busy;
+    std::mutex runnerMutex;
+    std::condition_variable runnerCv;
+
+    JobRunner(std::vector<std::unique_ptr<FactoringJob>>& j, const unsigned& w)
+        : jobs(j)
+        , workerCount(w)
+        , jobsLeft(0U)
+        , busy(0U)
+    {
+        for (std::unique_ptr<FactoringJob>& job : jobs) {
+            if (job->scheduler.isExhausted()) {
+                // (Trivial, or nothing to search)
+                job->isDone = true;
+                job->report();
+            } else {
+                ++jobsLeft;
+            }
+        }
+    }
+
+    // The next job to work on, (or null, when all are done,) and the threads to run its next engine stage
+    // on, (or 0, for one batch claim).
+    FactoringJob* pick(unsigned& threads)
+    {
+        std::unique_lock<std::mutex> lock(runnerMutex);
+        while (jobsLeft) {
+            FactoringJob* best = nullptr;
+            double bestCost = DBL_MAX;
+            for (std::unique_ptr<FactoringJob>& job : jobs) {
+                if (busy >= workerCount) {
+                    break;
+                }
+                if (job->isDone || job->scheduler.isExhausted()) {
+                    continue;
+                }
+                if (job->isInStages()) {
+                    if (job->isStageRunning) {
+                        continue;
+                    }
+                } else {
+                    const uint64_t claimed = job->scheduler.claimed.load(std::memory_order_relaxed);
+                    const uint64_t unclaimed =
+                        (claimed < job->scheduler.total) ? (job->scheduler.total - claimed) : 0U;
+                    if (job->activeWorkers >= unclaimed) {
+                        continue;
+                    }
+                }
+                const double remaining = job->remainingCost();
+                if (!best || (remaining < bestCost)) {
+                    best = job.get();
+                    bestCost = remaining;
+                }
+            }
+
+            if (best) {
+                if (!best->isStarted) {
+                    best->isStarted = true;
+                    best->scheduler.startClock();
+                }
+                // (A stage gets its fair share of all the threads, so one long engine run doesn't hold up the
+                // rest of the jobs.)
+                threads = best->isInStages()
+                    ? std::min(workerCount - busy, (unsigned)((workerCount + jobsLeft - 1U) / jobsLeft))
+                    : 0U;
+                if (threads) {
+                    best->isStageRunning = true;
+                }
+                busy += threads ? threads : 1U;
+                ++(best->activeWorkers);
+                return best;
+            }
+
+            // Everything left is already fully staffed, (or every thread is busy); wait for a job (or
+            // worker) to free up.
+            runnerCv.wait(lock);
+        }
+
+        return nullptr;
+    }
+
+    // (With "runnerMutex" held)
+    void finishIfDone(FactoringJob* job)
+    {
+        if (!job->activeWorkers && !job->isDone && job->scheduler.isExhausted()) {
+            job->isDone = true;
+            --jobsLeft;
+            job->report();
+        }
+    }
+
+    void release(FactoringJob* job)
+    {
+        std::lock_guard<std::mutex> lock(runnerMutex);
+        --busy;
+        --(job->activeWorkers);
+        finishIfDone(job);
+        runnerCv.notify_all();
+    }
+
+    // Run the job's next engine stage, within what's left of its budget, and pass on its outcome.
+    void runStage(FactoringJob* job, const unsigned& threads)
+    {
+        const JobStage& stage = job->stages[job->stageIndex];
+        BatchScheduler clock;
+        clock.isQuiet = true;
+        double seconds = stage.seconds;
+        if (job->budget > 0.0) {
+            const double left = std::max(1e-3, job->budget - job->scheduler.elapsed());
+            seconds = (seconds > 0.0) ? std::min(seconds, left) : left;
+        }
+        clock.budget = std::chrono::nanoseconds((int64_t)(seconds * 1e9));
+        const bool isRun = stage.run(threads, clock);
+
+        std::lock_guard<std::mutex> lock(runnerMutex);
+        BatchScheduler& scheduler = job->scheduler;
+        if (!clock.result.empty()) {
+            scheduler.setResult(clock.result, clock.factor);
+            scheduler.finish();
+        } else if (clock.isInterrupted) {
+            scheduler.isInterrupted = true;
+            scheduler.finish();
+        } else if (isRun && stage.isFinal) {
+            // (Nothing else to search)
+            scheduler.isTimedOut = clock.isTimedOut.load();
+            scheduler.finish();
+        } else {
+            // (This sets the job's own flags, if its budget ran out.)
+            scheduler.isStopped();
+        }
+        busy -= threads;
+        --(job->activeWorkers);
+        job->isStageRunning = false;
+        ++(job->stageIndex);
+        finishIfDone(job);
+        runnerCv.notify_all();
+    }
+};
+
+// Non-interactive mode: one job per line, "<number> [wheel level, or -1 for calibration] [seconds]"
+// (A time budget of 0 means no limit, and the "--timeout" option applies to lines without their own.)
+int batchMain(const std::string& jobFile, const RunOptions& options)
+{
+    std::ifstream file;
+    if (jobFile != "-") {
+        file.open(jobFile);
+        if (!file.is_open()) {
+            std::cout << "Could not open job file: " << jobFile << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = (jobFile == "-") ? std::cin : file;
+
+    const unsigned workerCount = std::max(1U, std::thread::hardware_concurrency());
+    CalibrationStore store(getSearchOptions(options.sieveBound));
+    store.load();
+
+    std::vector<std::unique_ptr<FactoringJob>> jobs;
+    std::string line;
+    for (size_t lineNumber = 1U; std::getline(input, line); ++lineNumber) {
+        if (line.empty() || (line.find_first_not_of(" \t\r") == std::string::npos) || (line[0] == '#')) {
+            continue;
+        }
+
+        std::unique_ptr<FactoringJob> job(new FactoringJob());
+        job->id = lineNumber;
+#if IS_RANDOM
+        job->scheduler.seed = options.seed;
+#endif
+        std::stringstream ss(line);
+        ss >> job->toFactor;
+        if (ss.fail() || (job->toFactor < 2U)) {
+            std::cout << "[" << job->id << "] Invalid job: " << line << std::endl;
+            continue;
+        }
+        if (!(ss >> job->level) || (job->level < 0)) {
+            // (Calibrated per job, by its own width)
+            job->level = -1;
+        } else {
+            job->level = std::min(std::max(job->level, (int64_t)MIN_RTD_LEVEL), (int64_t)MAX_WHEEL_LEVEL);
+        }
+        if (!(ss >> job->budget) || (job->budget < 0.0)) {
+            job->budget = options.timeout;
+        }
+
+        dispatchByWidth<PrepareJob>(
+            getSearchWidth(getQubitCount(job->toFactor)), job->toFactor, *job, workerCount, store, options);
+        jobs.push_back(std::move(job));
+    }
 
-    const auto workerFn = [toFactor, &inc_seqs, &offset, &iterClock] {
-        std::vector<boost::dynamic_bitset<uint64_t>> inc_seqs_clone;
-        inc_seqs_clone.reserve(inc_seqs.size());
-        for (const auto& b : inc_seqs) {
-            inc_seqs_clone.emplace_back(b);
+    JobRunner runner(jobs, workerCount);
+    const auto workerFn = [&runner] {
+        unsigned threads = 0U;
+        for (FactoringJob* job = runner.pick(threads); job; job = runner.pick(threads)) {
+            if (threads) {
+                runner.runStage(job, threads);
+                continue;
+            }
+            WheelIterator wheel(job->level);
+            job->work(wheel, 1U);
+            runner.release(job);
         }
-        getSmoothNumbers(toFactor, inc_seqs_clone, offset, iterClock);
     };
 
     std::vector<std::future<void>> futures;
-    futures.reserve(cpuCount);
-
-    for (unsigned cpu = 0U; cpu < cpuCount; ++cpu) {
+    futures.reserve(workerCount);
+    for (unsigned cpu = 0U; cpu < workerCount; ++cpu) {
         futures.push_back(std::async(std::launch::async, workerFn));
     }
-
-    for (unsigned cpu = 0U; cpu < cpuCount; ++cpu) {
+    for (unsigned cpu = 0U; cpu < workerCount; ++cpu) {
         futures[cpu].get();
     }
 
     return 0;
 }
+
+// Each chunk of the batch GCD trees runs at the narrowest integer type that holds it. (There's no one
+// number to factor, so the dispatch just converts a placeholder 0.)
+template <typename BigInteger> struct GcdChunkBody {
+    static int run(const BigInteger&, GcdChunk& chunk)
+    {
+        chunk.run<BigInteger>();
+
+        return 0;
+    }
+};
+
+// Corpus mode: report every modulus, (one per line,) that shares a factor with another.
+int batchGcdMain(const std::string& corpusFile, const RunOptions& options)
+{
+    const unsigned workerCount = std::max(1U, std::thread::hardware_concurrency());
+    const BigIntegerInput placeholder = 0U;
+
+    return runBatchGcd(corpusFile, options.gcdMemory, options.gcdSpillDir, workerCount,
+        [&placeholder](GcdChunk& chunk) { return dispatchByMinWidth<GcdChunkBody>(chunk.width, placeholder, chunk); });
+}
+
+template <typename BigInteger> struct PerfectPowerBody {
+    static int run(const BigInteger& n, BigIntegerInput& root, uint64_t& k)
+    {
+        BigInteger r = 0U;
+        k = getPerfectPower(n, r);
+        root = (BigIntegerInput)r;
+
+        return 0;
+    }
+};
+
+// The smallest prime "k" for which "n" is a perfect k-th power, (setting "root,") or 0, for none, or
+// if this build has no integer wide enough to check.
+inline uint64_t findPerfectPower(const BigIntegerInput& n, BigIntegerInput& root)
+{
+    uint64_t k = 0U;
+    if (dispatchByMinWidth<PerfectPowerBody>(2U * getQubitCount(n) + 2U, n, root, k)) {
+        return k;
+    }
+#if USE_GMP || USE_BOOST
+    CorpusInteger r = 0U;
+    k = getPerfectPower((CorpusInteger)n, r);
+    root = (BigIntegerInput)r;
+#endif
+
+    return k;
+}
+
+// One nontrivial factor of the composite "n," or 0, if no engine finds one within the budget of
+// "clock." Pollard's rho goes first, (briefly, if the quadratic sieve can take over,) for a small
+// factor, then the quadratic sieve, then rho again, with whatever time is left, (for the prime powers
+// that the sieve can't split).
+inline BigIntegerInput splitComposite(const BigIntegerInput& n, const unsigned& workerCount, BatchScheduler& clock)
+{
+    const uint32_t bits = getQubitCount(n);
+    const bool isSiqsSized = !(bits < SIQS_MIN_BITS);
+    const double rhoSeconds =
+        FACTORIZE_RHO_SECONDS * std::exp2((bits - (double)SIQS_MIN_BITS) / FACTORIZE_RHO_DOUBLING_BITS);
+    for (size_t stage = 0U; stage < 3U; ++stage) {
+        if ((!isSiqsSized && (stage > 0U)) || clock.isStopped()) {
+            break;
+        }
+        // (Zero for no time limit)
+        double seconds = 0.0;
+        if (clock.budget.count()) {
+            seconds = std::max(1e-3, (clock.budget.count() / 1e9) - clock.elapsed());
+        }
+        BatchScheduler engine;
+        engine.isQuiet = true;
+        bool isRun;
+        if (stage == 1U) {
+            engine.budget = std::chrono::nanoseconds((int64_t)(seconds * 1e9));
+            isRun = runSiqsSearch(n, 0U, workerCount, engine);
+        } else {
+            if (isSiqsSized && (stage == 0U)) {
+                seconds = (seconds > 0.0) ? std::min(seconds, rhoSeconds) : rhoSeconds;
+            }
+            engine.budget = std::chrono::nanoseconds((int64_t)(seconds * 1e9));
+            isRun = runRhoSearch(n, 1U, 0U, workerCount, engine);
+        }
+        const BigIntegerInput& f = engine.factor;
+        if (isRun && (1U < f) && (f < n) && ((n % f) == 0U)) {
+            std::cout << engine.result << std::endl;
+            return f;
+        }
+    }
+
+    return 0U;
+}
+
+// Complete factorization mode: strip the small primes, then split every composite cofactor, (by
+// whichever engine suits its size,) until only primes are left, or the time budget runs out.
+int factorizeMain(const BigIntegerInput& toFactor, const RunOptions& options)
+{
+    if (toFactor < 2U) {
+        std::cout << "Nothing to factor: " << toFactor << " has no prime factors." << std::endl;
+        return 1;
+    }
+
+    const unsigned workerCount = std::max(1U, std::thread::hardware_concurrency());
+    BatchScheduler clock;
+    clock.budget = std::chrono::nanoseconds((int64_t)(options.timeout * 1e9));
+
+    Factorization factorization(toFactor);
+    const BigIntegerInput cofactor = stripSmallFactors(toFactor, options.stripBound, factorization);
+    if (!factorization.primes.empty()) {
+        std::cout << "Trial division (primes to " << options.stripBound << "): Found " << factorization.str()
+                  << ", leaving " << cofactor << std::endl;
+    }
+
+    std::vector<BigIntegerInput> pending(1U, cofactor);
+    while (!pending.empty()) {
+        const BigIntegerInput n = pending.back();
+        pending.pop_back();
+        if (n == 1U) {
+            continue;
+        }
+
+        bool isPrime = false;
+        if (!testPrime(n, isPrime)) {
+            factorization.untested.push_back(n);
+            continue;
+        }
+        if (isPrime) {
+            factorization.addPrime(n);
+            continue;
+        }
+
+        // (Neither rho nor the quadratic sieve splits a perfect power of a prime, efficiently, if at all.)
+        BigIntegerInput root = 0U;
+        const uint64_t k = findPerfectPower(n, root);
+        if (k) {
+            std::cout << "Perfect power: Found " << root << "^" << k << " = " << n << std::endl;
+            pending.insert(pending.end(), (size_t)k, root);
+            continue;
+        }
+
+        const BigIntegerInput f = splitComposite(n, workerCount, clock);
+        if (f == 0U) {
+            factorization.composites.push_back(n);
+            continue;
+        }
+        pending.push_back(f);
+        pending.push_back(n / f);
+    }
+
+    std::cout << "Factorization: " << factorization.str() << " = " << toFactor << std::endl;
+    if (!factorization.composites.empty()) {
+        std::cout << "(Bracketed cofactors are composite, but weren't split"
+                  << (clock.isInterrupted ? ", before the interrupt" : " within the time budget") << ".)" << std::endl;
+    }
+    if (!factorization.untested.empty()) {
+        std::cout << "(Parenthesized cofactors are too wide for this build to test for primality: rebuild with a "
+                     "higher BIG_INT_BITS.)"
+                  << std::endl;
+    }
+    if (factorization.isProbable()) {
+        std::cout << "(Prime factors of more than " << PRIME_TEST_PROOF_BITS
+                  << " bits are Miller-Rabin probable primes.)" << std::endl;
+    }
+    std::cout << "(Time elapsed: " << clock.elapsed() << " seconds)" << std::endl;
+
+    return factorization.isComplete() ? 0 : 1;
+}
 } // namespace Qimcifa
 
 using namespace Qimcifa;
 
-int main()
+// The first SIGINT (or SIGTERM) asks every worker to stop, at its next check, after which we save
+// a final checkpoint. A second one kills the process.
+extern "C" void onInterrupt(int signal)
 {
+    requestStop();
+    std::signal(signal, SIG_DFL);
+}
+
+int main(int argc, char* argv[])
+{
+    bool isBatch = false;
+    std::string jobFile = "-";
+    std::string corpusFile;
+    RunOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        const bool isValue = (i + 1) < argc;
+        if (arg == "--batch") {
+            isBatch = true;
+            // Read jobs from the named file, or from standard input.
+            if (isValue && ((argv[i + 1][0] != '-') || !argv[i + 1][1])) {
+                jobFile = argv[++i];
+            }
+        } else if ((arg == "--batch-gcd") && isValue) {
+            corpusFile = argv[++i];
+        } else if ((arg == "--gcd-memory") && isValue) {
+            options.gcdMemory = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((arg == "--gcd-spill-dir") && isValue) {
+            options.gcdSpillDir = argv[++i];
+        } else if ((arg == "--timeout") && isValue) {
+            options.timeout = std::max(0.0, std::atof(argv[++i]));
+        } else if ((arg == "--checkpoint") && isValue) {
+            options.checkpointPath = argv[++i];
+        } else if ((arg == "--checkpoint-interval") && isValue) {
+            options.checkpointInterval = std::max(0.0, std::atof(argv[++i]));
+        } else if ((arg == "--shared-dir") && isValue) {
+            options.sharedDir = argv[++i];
+        } else if ((arg == "--lease-ttl") && isValue) {
+            options.leaseTtl = std::max(1.0, std::atof(argv[++i]));
+        } else if ((arg == "--lease-batches") && isValue) {
+            options.leaseBatches = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((arg == "--stats-interval") && isValue) {
+            options.statsInterval = std::max(0.0, std::atof(argv[++i]));
+        } else if ((arg == "--stats-file") && isValue) {
+            options.statsFile = argv[++i];
+        } else if ((arg == "--sieve-bound") && isValue) {
+            options.sieveBound = std::strtoull(argv[++i], nullptr, 10);
+        } else if (((arg == "--lower-bound") || (arg == "--upper-bound")) && isValue) {
+            std::stringstream ss(argv[++i]);
+            ss >> ((arg == "--lower-bound") ? options.lowerBound : options.upperBound);
+        } else if ((arg == "--factor-bits") && isValue) {
+            // The smaller factor has exactly this many bits.
+            const uint32_t bits = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            if (bits) {
+                options.lowerBound = ((BigIntegerInput)1U) << (bits - 1U);
+                options.upperBound = (((BigIntegerInput)1U) << bits) - 1U;
+            }
+        } else if (arg == "--fermat") {
+            options.isFermat = true;
+        } else if ((arg == "--fermat-prepass") && isValue) {
+            options.fermatPrepass = std::max(0.0, std::atof(argv[++i]));
+        } else if ((arg == "--rho-prepass") && isValue) {
+            options.rhoPrepass = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--siqs") {
+            options.isSiqs = true;
+        } else if (arg == "--factorize") {
+            options.isFactorize = true;
+        } else if ((arg == "--strip-bound") && isValue) {
+            options.stripBound = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-checkpoint") {
+            options.isCheckpointing = false;
+#if IS_RANDOM
+        } else if ((arg == "--seed") && isValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+#endif
+        } else {
+            std::cout << "Usage: " << argv[0]
+                      << " [--timeout <seconds>] [--checkpoint <file>] [--checkpoint-interval <seconds>] "
+                         "[--no-checkpoint] [--shared-dir <directory>] [--lease-ttl <seconds>] "
+                         "[--lease-batches <count>] [--stats-interval <seconds>] [--stats-file <file>] "
+                         "[--sieve-bound <prime bound>] [--lower-bound <factor>] [--upper-bound <factor>] "
+                         "[--factor-bits <bits>] [--fermat] [--fermat-prepass <seconds>] "
+                         "[--rho-prepass <seconds>] [--siqs] [--factorize] [--strip-bound <prime bound>] "
+#if IS_RANDOM
+                         "[--seed <integer>] "
+#endif
+                         "[--batch [<job file>|-]] [--batch-gcd <corpus file>] [--gcd-memory <MiB>] "
+                         "[--gcd-spill-dir <directory>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    if (!corpusFile.empty()) {
+        return batchGcdMain(corpusFile, options);
+    }
+    if (isBatch) {
+        return batchMain(jobFile, options);
+    }
+
     BigIntegerInput toFactor;
 
     std::cout << "Number to factor: ";
     std::cin >> toFactor;
 
-    uint32_t qubitCount = 0;
-    BigIntegerInput p = toFactor >> 1U;
-    while (p != 0) {
-        p >>= 1U;
-        ++qubitCount;
-    }
-    if (!isPowerOfTwo(toFactor)) {
-        qubitCount++;
-    }
+    const uint32_t qubitCount = getQubitCount(toFactor);
     std::cout << "Bits to factor: " << (int)qubitCount << std::endl;
 
-#if !(USE_GMP || USE_BOOST)
-    typedef BigInteger BigInteger;
-    return mainBody<BigInteger>((BigInteger)toFactor);
-#else
-    if (qubitCount < 64) {
-        typedef uint64_t BigInteger;
-        return mainBody<BigInteger>((BigInteger)toFactor);
-#if USE_GMP
-    } else {
-        return mainBody<BigIntegerInput>(toFactor);
+    if (options.isFactorize) {
+        return factorizeMain(toFactor, options);
     }
-#elif USE_BOOST
-    } else if (qubitCount < 128) {
-        typedef boost::multiprecision::uint128_t BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 192) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<192, 192,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 256) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<256, 256,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 512) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<512, 512,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 1024) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<1024, 1024,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 2048) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<2048, 2048,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 4096) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<4096, 4096,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    } else if (qubitCount < 8192) {
-        typedef boost::multiprecision::number<boost::multiprecision::cpp_int_backend<8192, 8192,
-            boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>
-            BigInteger;
-        return mainBody((BigInteger)toFactor);
-    }
-
-    if (qubitCount >= 8192) {
-        throw std::runtime_error("Number to factor exceeds 8192 templated max bit width!");
-    }
-#endif
-#endif
 
-    return 0;
+    return dispatchByWidth<MainBody>(getSearchWidth(qubitCount), toFactor, options);
 }